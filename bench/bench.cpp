@@ -0,0 +1,787 @@
+// Headless benchmark for all modules in the plugin.
+// Every module is created from its Model, patched as described in the scenario table below and driven through process()
+// for a number of samples at each polyphony count and sample rate. The result is the average CPU time per sample.
+//
+// After the modules, the wavetable reads are measured on their own: the signal-to-noise ratio and cost of each interpolation mode.
+// Then the cost of Harmoblender against pitch, as its partials near Nyquist are culled.
+// Then the soft saturation curves of Clipper: the largest error of each approximation and its cost against libm.
+// Then the aliasing of Clipper against its cost, for each oversampling factor and order of antiderivative anti-aliasing.
+// Last, the largest output of Clipper's antiderivative anti-aliasing while the threshold CV moves.
+//
+// Usage: bench [-n samples] [filter]
+//   -n samples  Number of timed samples per measurement (default 1000000)
+//   filter      Only run scenarios whose label contains this text. "Interpolation" only runs the wavetable measurement,
+//               "Harmoblender Pitch" only the Harmoblender pitch measurement, "Saturation" only the saturation curves,
+//               "Clipper Aliasing" only the Clipper aliasing measurement, "Clipper Moving Threshold" only the moving threshold
+
+#include <rack.hpp>
+#include <chrono>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "../src/sts-wavetables.hpp"
+#include "../src/sts-saturation.hpp"
+
+using namespace rack;
+
+// Kinds of signals fed to the polyphonic input of a module
+enum Signal
+{
+	SIGNAL_VOCT,  // Static pitch per channel, spread over a few octaves
+	SIGNAL_AUDIO, // +/- 8V sine per channel, different frequency per channel
+	SIGNAL_GATE,  // 0/10V square at 4 Hz
+	SIGNAL_PITCH  // The same static pitch in all channels
+};
+
+struct Scenario
+{
+	const char *label;				// Name printed in the report
+	const char *slug;				// Model slug
+	const char *polyInput;			// Name of the input receiving the polyphonic signal, NULL if the module has none
+	Signal signal;					// Signal fed to polyInput
+	const char *state;				// Context menu state, as the JSON passed to dataFromJson(), NULL if none
+	void (*setup)(Module *module);	// Extra param setup, NULL if none. Also applied to the expanders
+	const char *expanderSlug;		// Model slug of the expanders chained to the right, NULL if none
+	int numExpanders;				// Number of expanders
+};
+
+static int findInput(Module *module, const char *name)
+{
+	for (int i = 0; i < (int)module->inputInfos.size(); i++)
+	{
+		if (module->inputInfos[i] && module->inputInfos[i]->name == name)
+			return i;
+	}
+	return -1;
+}
+
+// Set all params whose name starts with prefix
+static void setParams(Module *module, const char *prefix, float value)
+{
+	for (ParamQuantity *pq : module->paramQuantities)
+	{
+		if (pq && pq->name.compare(0, strlen(prefix), prefix) == 0)
+			pq->setValue(value);
+	}
+}
+
+static void setupHarmoblender(Module *module)
+{
+	// All 16 partials at half level, keeping the default multipliers
+	for (ParamQuantity *pq : module->paramQuantities)
+	{
+		if (pq && pq->name.compare(0, 9, "Harmonic ") == 0 && pq->name.find(" Level") != std::string::npos)
+			pq->setValue(0.5f);
+	}
+}
+
+// 4 snapshots of 16 partials morphed at 3.3V, so between the second and third
+static void setupHarmoblenderMorph(Module *module)
+{
+	json_t *rootJ = json_object();
+	json_t *snapshotsJ = json_array();
+	Input &morph = module->getInput(findInput(module, "Snapshot Morph (0..10V)"));
+
+	setupHarmoblender(module);
+	for (int i = 0; i < 4; i++)
+	{
+		json_t *partialsJ = json_array();
+		for (int j = 0; j < 16; j++)
+		{
+			json_t *partialJ = json_array();
+			json_array_append_new(partialJ, json_real(0.5 / (1 + ((i + 1) * j) % 7)));
+			json_array_append_new(partialJ, json_real(0.0));
+			json_array_append_new(partialJ, json_integer(j + 1));
+			json_array_append_new(partialsJ, partialJ);
+		}
+		json_array_append_new(snapshotsJ, partialsJ);
+	}
+	json_object_set_new(rootJ, "Snapshots", snapshotsJ);
+	module->dataFromJson(rootJ);
+	json_decref(rootJ);
+
+	morph.channels = 1;
+	morph.voltages[0] = 3.3f;
+
+	// Give the worker thread time to bake the snapshot tables
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+static void setupSuperZzzaw(Module *module)
+{
+	// 5 active saws out of 12, as in a typical supersaw patch
+	const char *levels[] = {"Sawtooth 1 Level", "Sawtooth 2 Level", "Sawtooth 3 Level", "Sawtooth 4 Level", "Sawtooth 5 Level"};
+	const char *detunes[] = {"Sawtooth 2 Detune", "Sawtooth 3 Detune", "Sawtooth 4 Detune", "Sawtooth 5 Detune"};
+	for (const char *level : levels)
+		setParams(module, level, 0.5f);
+	for (int i = 0; i < 4; i++)
+		setParams(module, detunes[i], (i & 1 ? -0.5f : 0.5f) * (1 + i / 2));
+}
+
+static void setupTicker(Module *module)
+{
+	setParams(module, "Run", 1.f);
+}
+
+static void setupClipperCV(Module *module)
+{
+	// Polyphonic threshold CV, a different threshold in each channel
+	for (const char *name : {"Upper Threshold Modulation", "Lower Threshold Modulation"})
+	{
+		Input &input = module->getInput(findInput(module, name));
+		input.channels = PORT_MAX_CHANNELS;
+		for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+			input.voltages[c] = 0.25f * c;
+	}
+	setParams(module, "Attenuation for", 0.5f);
+}
+
+static const Scenario scenarios[] = {
+	{"Sine-VCO", "Sine-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, NULL},
+	{"Saw-VCO", "Saw-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, NULL},
+	{"Saw-VCO Limited", "Saw-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 1}", NULL},
+	{"Saw-VCO PolyBLEP", "Saw-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 2}", NULL},
+	{"Triangle-VCO", "Triangle-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, NULL},
+	{"Triangle-VCO Limited", "Triangle-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 1}", NULL},
+	{"Triangle-VCO PolyBLEP", "Triangle-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 2}", NULL},
+	{"Pulse-VCO", "Pulse-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, NULL},
+	{"Pulse-VCO Limited", "Pulse-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 1}", NULL},
+	{"Pulse-VCO PolyBLEP", "Pulse-VCO", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 2}", NULL},
+	{"Harmoblender", "Harmoblender", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, setupHarmoblender},
+	{"Harmoblender Baked", "Harmoblender", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Synthesis\": 1}", setupHarmoblender},
+	{"Harmoblender Morph", "Harmoblender", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, setupHarmoblenderMorph},
+	{"Harmoblender Resynth", "Harmoblender", "Resynthesis (audio)", SIGNAL_AUDIO, NULL, setupHarmoblender},
+	{"Harmoblender 64", "Harmoblender", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, setupHarmoblender, "Harmoblender-Expander", 3},
+	{"Harmoblender 64 Baked", "Harmoblender", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Synthesis\": 1}", setupHarmoblender, "Harmoblender-Expander", 3},
+	{"SuperZzzaw", "SuperZzzaw", "Pitch (V//Oct)", SIGNAL_VOCT, NULL, setupSuperZzzaw},
+	{"SuperZzzaw Limited", "SuperZzzaw", "Pitch (V//Oct)", SIGNAL_VOCT, "{\"Band\": 1}", setupSuperZzzaw},
+	{"Clipper Clip", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1}", NULL},
+	{"Clipper Fold", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 1, \"Polarity\": 1}", NULL},
+	{"Clipper Clip Poly CV", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1}", setupClipperCV},
+	{"Clipper Fold Poly CV", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 1, \"Polarity\": 1}", setupClipperCV},
+	{"Clipper Multi-fold", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 2, \"Polarity\": 1}", NULL},
+	{"Clipper Multi-fold ADAA2", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 2, \"Polarity\": 1, \"Anti-aliasing\": 2}", NULL},
+	{"Clipper Tanh", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 3, \"Polarity\": 1}", NULL},
+	{"Clipper Soft-knee", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 4, \"Polarity\": 1}", NULL},
+	{"Clipper Diode", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 5, \"Polarity\": 1}", NULL},
+	{"Clipper Sine-fold", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Clip Method\": 6, \"Polarity\": 1}", NULL},
+	{"Clipper Clip 2x", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1, \"Oversampling\": 1}", NULL},
+	{"Clipper Clip 4x", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1, \"Oversampling\": 2}", NULL},
+	{"Clipper Clip 8x", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1, \"Oversampling\": 3}", NULL},
+	{"Clipper Clip ADAA1", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1, \"Anti-aliasing\": 1}", NULL},
+	{"Clipper Clip ADAA2", "Clipper", "Audio In", SIGNAL_AUDIO, "{\"Polarity\": 1, \"Anti-aliasing\": 2}", NULL},
+	{"Splitter", "Splitter", "Polyphonic", SIGNAL_VOCT, NULL, NULL},
+	{"Splitter Pitch Up", "Splitter", "Polyphonic", SIGNAL_VOCT, "{\"Sort Outputs\": 1}", NULL},
+	{"Splitter Pitch Down", "Splitter", "Polyphonic", SIGNAL_VOCT, "{\"Sort Outputs\": 2}", NULL},
+	{"Splitter 16 Outputs", "Splitter", "Polyphonic", SIGNAL_VOCT, "{\"Sort Outputs\": 1}", NULL, "Splitter-Expander", 3},
+	{"Multiplier", "Multiplier", "Signal", SIGNAL_AUDIO, NULL, NULL},
+	{"D-Octer", "D-Octer", "V/Oct", SIGNAL_VOCT, NULL, NULL},
+	{"Ticker", "Ticker", NULL, SIGNAL_GATE, NULL, setupTicker},
+	{"Spiquencer", "Spiquencer", "Gate In", SIGNAL_GATE, NULL, NULL},
+};
+
+static const int channelCounts[] = {0, 1, 4, 16};
+static const float sampleRates[] = {44100.f, 48000.f, 96000.f, 192000.f};
+
+// Length of the precomputed input signal, so generating it does not add to the measured time
+static const int SIGNAL_LEN = 4096;
+
+static Model *findModel(Plugin *plugin, const char *slug)
+{
+	for (Model *model : plugin->models)
+	{
+		if (model->slug == slug)
+			return model;
+	}
+	return NULL;
+}
+
+// Minimal JSON object parser for the scenario state strings: {"key": integer, ...}
+static json_t *parseState(const char *state)
+{
+	json_t *rootJ = json_object();
+	const char *p = state;
+	while ((p = strchr(p, '"')))
+	{
+		const char *end = strchr(p + 1, '"');
+		std::string key(p + 1, end);
+		p = strchr(end, ':') + 1;
+		json_object_set_new(rootJ, key.c_str(), json_integer(strtol(p, (char **)&p, 10)));
+	}
+	return rootJ;
+}
+
+static void fillSignal(std::vector<float> &buffer, Signal signal, int channels, float sampleRate, float voct)
+{
+	buffer.assign(SIGNAL_LEN * PORT_MAX_CHANNELS, 0.f);
+	for (int c = 0; c < channels; c++)
+	{
+		for (int s = 0; s < SIGNAL_LEN; s++)
+		{
+			float v = 0.f;
+			switch (signal)
+			{
+			case SIGNAL_VOCT:
+				v = -1.f + 0.25f * c;
+				break;
+			case SIGNAL_AUDIO:
+				// Whole number of cycles in the buffer, so looping it does not click
+				v = 8.f * std::sin(2.f * M_PI * (c + 1) * 10 * s / SIGNAL_LEN);
+				break;
+			case SIGNAL_GATE:
+				v = (std::fmod(s * 4.f / sampleRate, 1.f) < 0.5f) ? 10.f : 0.f;
+				break;
+			case SIGNAL_PITCH:
+				v = voct;
+				break;
+			}
+			buffer[s * PORT_MAX_CHANNELS + c] = v;
+		}
+	}
+}
+
+// As the engine does after each sample: swap the expander message buffers of a module that asked for it
+static void flipMessages(Module *module)
+{
+	for (Module::Expander *expander : {&module->leftExpander, &module->rightExpander})
+	{
+		if (expander->messageFlipRequested)
+		{
+			std::swap(expander->producerMessage, expander->consumerMessage);
+			expander->messageFlipRequested = false;
+		}
+	}
+}
+
+// Returns the average ns/sample for one scenario at one channel count and sample rate. voct is the pitch of SIGNAL_PITCH
+static double measure(Model *model, const Scenario &scenario, int channels, float sampleRate, long samples, float voct = 0.f)
+{
+	static volatile float sink __attribute__((unused));
+	std::vector<float> signal;
+	Module *module;
+	std::vector<Module *> expanders;
+	Input *input = NULL;
+	Module::ProcessArgs args;
+	Module::SampleRateChangeEvent e;
+	float sum = 0.f;
+	long s;
+
+	APP->engine->sampleRate = sampleRate;
+	module = model->createModule();
+
+	if (scenario.state)
+	{
+		json_t *stateJ = parseState(scenario.state);
+		module->dataFromJson(stateJ);
+		json_decref(stateJ);
+	}
+	if (scenario.setup)
+		scenario.setup(module);
+
+	// Chain the expanders to the right, they are processed before the module
+	for (int i = 0; i < scenario.numExpanders; i++)
+	{
+		Module *expander = findModel(model->plugin, scenario.expanderSlug)->createModule();
+		Module *left = expanders.empty() ? module : expanders.back();
+
+		if (scenario.setup)
+			scenario.setup(expander);
+		left->rightExpander.module = expander;
+		left->rightExpander.moduleId = expander->id;
+		expander->leftExpander.module = left;
+		expander->leftExpander.moduleId = left->id;
+		expanders.push_back(expander);
+	}
+
+	// Connect all outputs, as Rack would with cables plugged in
+	for (Output &output : module->outputs)
+		output.channels = 1;
+
+	if (scenario.polyInput && channels > 0)
+	{
+		input = &module->getInput(findInput(module, scenario.polyInput));
+		input->channels = channels;
+		fillSignal(signal, scenario.signal, channels, sampleRate, voct);
+	}
+
+	e.sampleRate = sampleRate;
+	e.sampleTime = 1.f / sampleRate;
+	module->onSampleRateChange(e);
+
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	args.frame = 0;
+
+	// Warm up caches and let any lazy initialisation settle before timing
+	for (s = 0; s < SIGNAL_LEN; s++, args.frame++)
+	{
+		if (input)
+			memcpy(input->voltages, &signal[(s % SIGNAL_LEN) * PORT_MAX_CHANNELS], sizeof(input->voltages));
+		for (Module *expander : expanders)
+			expander->process(args);
+		module->process(args);
+		for (Module *expander : expanders)
+			flipMessages(expander);
+		flipMessages(module);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (s = 0; s < samples; s++, args.frame++)
+	{
+		if (input)
+			memcpy(input->voltages, &signal[(s % SIGNAL_LEN) * PORT_MAX_CHANNELS], sizeof(input->voltages));
+		for (Module *expander : expanders)
+			expander->process(args);
+		module->process(args);
+		for (Module *expander : expanders)
+			flipMessages(expander);
+		flipMessages(module);
+		sum += module->outputs[0].voltages[0];
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	sink = sum;
+	for (Module *expander : expanders)
+		delete expander;
+	delete module;
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / samples;
+}
+
+// Time stamp counter, in reference cycles. 0 where there is none, the cycles column then reads 0
+static inline uint64_t readCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Signal-to-noise ratio in dB of reading the sine table at freq Hz, against the exact sine
+static double measureSNR(const STS_Wavetable *sine, int interpolation, float freq, float sampleRate)
+{
+	double signal = 0.0, noise = 0.0, exact, error;
+	uint32_t phase = 0, inc = STS_Fixed_Phase(freq / sampleRate);
+	float frac;
+	int index;
+
+	for (int s = 0; s < (int)sampleRate; s++, phase += inc)
+	{
+		index = STS_Wave_Index(phase, &frac);
+		exact = 5.0 * std::sin(2.0 * M_PI * (phase / 4294967296.0));
+		error = STS_Wave_Sample(sine, index, frac, interpolation) - exact;
+		signal += exact * exact;
+		noise += error * error;
+	}
+	return 10.0 * std::log10(signal / noise);
+}
+
+// Interpolation modes against SNR at a low, middle and high pitch, and the cost of a table read for 16 voices
+static void measureInterpolation(long samples)
+{
+	static const char *modes[] = {"None", "Linear", "Cubic"};
+	static const float freqs[] = {55.f, 440.f, 3520.f};
+	static volatile float sink __attribute__((unused));
+	const float sampleRate = 48000.f;
+	std::shared_ptr<const STS_Wavetable> sine = STS_Get_Wavetable(STS_WAVE_SINE);
+	uint32_t phase[PORT_MAX_CHANNELS], inc[PORT_MAX_CHANNELS];
+	float frac, sum = 0.f;
+	int index;
+
+	printf("\nWavetable interpolation, %d-sample sine table at %.1fk, 16 voices for the cost\n\n", STS_NUM_WAVE_SAMPLES, sampleRate / 1000.f);
+	printf("%-22s", "Mode");
+	for (float freq : freqs)
+		printf(" %7.0fHz dB", freq);
+	printf(" %10s %10s\n", "ns/sample", "cyc/sample");
+
+	for (int mode = STS_INTERPOLATE_NONE; mode <= STS_INTERPOLATE_CUBIC; mode++)
+	{
+		printf("%-22s", modes[mode]);
+		for (float freq : freqs)
+			printf(" %12.1f", measureSNR(sine.get(), mode, freq, sampleRate));
+
+		for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+		{
+			phase[c] = 0;
+			inc[c] = STS_Fixed_Phase(55.f * std::pow(2.f, c * 0.25f) / sampleRate);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		uint64_t startCycles = readCycles();
+		for (long s = 0; s < samples; s++)
+		{
+			for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+			{
+				phase[c] += inc[c];
+				index = STS_Wave_Index(phase[c], &frac);
+				sum += STS_Wave_Sample(sine.get(), index, frac, mode);
+			}
+		}
+		uint64_t endCycles = readCycles();
+		auto end = std::chrono::steady_clock::now();
+
+		printf(" %10.2f %10.1f\n", std::chrono::duration<double, std::nano>(end - start).count() / samples, (double)(endCycles - startCycles) / samples);
+	}
+	sink = sum;
+}
+
+// Soft saturation curves against their exact versions with libm in double: the largest error over -20..20, and the cost for 16 voices
+// of the approximation, 4 at a time, and of libm in float, one at a time. The soft knee needs no libm, it is timed as the same
+// polynomial in float, one at a time
+static double exactSoftKnee(double x)
+{
+	x = std::fmax(std::fmin(x, 1.5), -1.5);
+	return x - 4.0 * x * x * x / 27.0;
+}
+
+static double exactDiode(double x)
+{
+	return x > 0.0 ? 1.0 - std::exp(-x) : exactSoftKnee(x);
+}
+
+static float libmSoftKnee(float x)
+{
+	x = std::fmax(std::fmin(x, 1.5f), -1.5f);
+	return x - 4.f * x * x * x / 27.f;
+}
+
+static float libmDiode(float x)
+{
+	return x > 0.f ? 1.f - std::exp(-x) : libmSoftKnee(x);
+}
+
+// Times a curve for 16 voices, the approximation 4 at a time and libm one at a time. Templates, so both are inlined alike
+template <simd::float_4 (*approx)(simd::float_4)>
+static double timeApprox(long samples)
+{
+	static volatile float sink __attribute__((unused));
+	simd::float_4 in[4], sum = 0.f;
+
+	// Inputs across the range of a hot signal, moving every sample so nothing is folded away
+	for (int c = 0; c < 4; c++)
+		in[c] = simd::float_4(-4.f, -3.5f, -3.f, -2.5f) + 2.f * c;
+
+	auto start = std::chrono::steady_clock::now();
+	for (long s = 0; s < samples; s++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			sum += approx(in[c]);
+			in[c] += 1e-7f;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	sink = sum[0] + sum[1] + sum[2] + sum[3];
+	return std::chrono::duration<double, std::nano>(end - start).count() / samples;
+}
+
+template <float (*libm)(float)>
+static double timeLibm(long samples)
+{
+	static volatile float sink __attribute__((unused));
+	float in[PORT_MAX_CHANNELS], sum = 0.f;
+
+	for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+		in[c] = -4.f + 0.5f * c;
+
+	auto start = std::chrono::steady_clock::now();
+	for (long s = 0; s < samples; s++)
+	{
+		for (int c = 0; c < PORT_MAX_CHANNELS; c++)
+		{
+			sum += libm(in[c]);
+			in[c] += 1e-7f;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	sink = sum;
+	return std::chrono::duration<double, std::nano>(end - start).count() / samples;
+}
+
+static float libmTanh(float x)
+{
+	return std::tanh(x);
+}
+
+static float libmSine(float x)
+{
+	return std::sin(x);
+}
+
+static void measureSaturation(long samples)
+{
+	struct Curve
+	{
+		const char *label;
+		simd::float_4 (*approx)(simd::float_4);
+		double (*exact)(double);
+		double (*approxTime)(long);
+		double (*libmTime)(long);
+	};
+	static const Curve curves[] = {
+		{"Tanh", STS_Tanh, [](double x) { return std::tanh(x); }, timeApprox<STS_Tanh>, timeLibm<libmTanh>},
+		{"Soft-knee", STS_Soft_Knee, exactSoftKnee, timeApprox<STS_Soft_Knee>, timeLibm<libmSoftKnee>},
+		{"Diode", STS_Diode, exactDiode, timeApprox<STS_Diode>, timeLibm<libmDiode>},
+		{"Sine-fold", STS_Sine, [](double x) { return std::sin(x); }, timeApprox<STS_Sine>, timeLibm<libmSine>},
+	};
+	const int steps = 1 << 20;
+	double error, worst, at;
+
+	printf("\nSoft saturation curves against libm, largest error over -20..20 and the cost for 16 voices\n\n");
+	printf("%-22s %10s %10s %10s %10s\n", "Curve", "max error", "at", "ns/sample", "libm");
+
+	for (const Curve &curve : curves)
+	{
+		worst = at = 0.0;
+		for (int i = 0; i <= steps; i++)
+		{
+			float x = -20.f + 40.f * i / steps;
+			error = std::fabs(curve.approx(simd::float_4(x))[0] - curve.exact(x));
+			if (error > worst)
+			{
+				worst = error;
+				at = x;
+			}
+		}
+		printf("%-22s %10.2e %10.3f %10.2f %10.2f\n", curve.label, worst, at, curve.approxTime(samples), curve.libmTime(samples));
+	}
+}
+
+// Harmoblender with all partials up against pitch, 16 voices at 48k. Partials past Nyquist are skipped, so the cost drops at high pitches.
+// Morphing plays the duller levels of the snapshots there instead, crossfading into the next level over each octave
+static void measurePitch(Model *model, long samples)
+{
+	static const Scenario pitchScenarios[] = {
+		{"Live", "Harmoblender", "Pitch (V//Oct)", SIGNAL_PITCH, NULL, setupHarmoblender},
+		{"Baked", "Harmoblender", "Pitch (V//Oct)", SIGNAL_PITCH, "{\"Synthesis\": 1}", setupHarmoblender},
+		{"Morph", "Harmoblender", "Pitch (V//Oct)", SIGNAL_PITCH, NULL, setupHarmoblenderMorph},
+	};
+	const float sampleRate = 48000.f;
+
+	printf("\nHarmoblender against pitch, 16 voices at %.1fk, ns/sample\n\n", sampleRate / 1000.f);
+	printf("%-22s %9s", "V/Oct", "Hz");
+	for (const Scenario &scenario : pitchScenarios)
+		printf(" %10s", scenario.label);
+	printf("\n");
+
+	for (float voct = -3.f; voct <= 6.f; voct += 1.f)
+	{
+		printf("%-22.1f %9.1f", voct, 261.6256f * std::pow(2.f, voct));
+		for (const Scenario &scenario : pitchScenarios)
+		{
+			printf(" %10.2f", measure(model, scenario, PORT_MAX_CHANNELS, sampleRate, samples, voct));
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+}
+
+// Aliasing of Clipper against its cost: a single 8V sine, hard clipped at +/-5V, and the part of the output that is not a harmonic of it.
+// The sine makes a whole number of cycles in one second, so its harmonics are exactly orthogonal over that second, and every
+// aliased component lands between them. The cost is for 16 voices
+static void measureAliasing(Model *model, long samples)
+{
+	struct Setting
+	{
+		const char *label;
+		int oversampling;
+		int antiAliasing;
+	};
+	static const Setting settings[] = {
+		{"Off", 0, 0},
+		{"2x", 1, 0},
+		{"4x", 2, 0},
+		{"8x", 3, 0},
+		{"ADAA 1st", 0, 1},
+		{"ADAA 2nd", 0, 2},
+		{"ADAA 1st 2x", 1, 1},
+		{"ADAA 2nd 2x", 1, 2},
+	};
+	static const char *methods[] = {"Clip", "Fold", "Multi"};
+	const float sampleRate = 48000.f, freq = 2113.f; // Prime, so no alias falls on a harmonic
+	const int len = (int)sampleRate;
+	std::vector<float> out(len);
+	Module::ProcessArgs args;
+	char state[96];
+	double total, harmonic, re, im;
+	int warmup = 1000, s, h;
+
+	printf("\nClipper aliasing, %.0f Hz 8V sine clipped at +/-5V at %.1fk: alias power below the harmonics, and ns/sample for 16 voices\n\n", freq, sampleRate / 1000.f);
+	printf("%-22s", "Anti-aliasing");
+	for (const char *method : methods)
+		printf(" %7s dB %9s", method, "ns/sample");
+	printf("\n");
+
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	for (const Setting &setting : settings)
+	{
+		printf("%-22s", setting.label);
+		for (int method = 0; method < 3; method++)
+		{
+			Module *module = model->createModule();
+			Input &input = module->getInput(findInput(module, "Audio In"));
+
+			snprintf(state, sizeof(state), "{\"Clip Method\": %d, \"Polarity\": 1, \"Oversampling\": %d, \"Anti-aliasing\": %d}", method, setting.oversampling, setting.antiAliasing);
+			json_t *stateJ = parseState(state);
+			module->dataFromJson(stateJ);
+			json_decref(stateJ);
+			input.channels = 1;
+			module->outputs[0].channels = 1;
+
+			args.frame = 0;
+			for (s = -warmup; s < len; s++, args.frame++)
+			{
+				input.voltages[0] = 8.f * std::sin(2.0 * M_PI * freq * (s + warmup) / sampleRate);
+				module->process(args);
+				if (s >= 0)
+					out[s] = module->outputs[0].voltages[0];
+			}
+			delete module;
+
+			// Power of the harmonics below Nyquist, by projecting the output on each of them, against the total power
+			total = 0.0;
+			for (s = 0; s < len; s++)
+				total += (double)out[s] * out[s];
+			harmonic = 0.0;
+			for (h = 0; h * freq < sampleRate / 2.f; h++)
+			{
+				re = im = 0.0;
+				for (s = 0; s < len; s++)
+				{
+					re += out[s] * std::cos(2.0 * M_PI * h * freq * s / sampleRate);
+					im += out[s] * std::sin(2.0 * M_PI * h * freq * s / sampleRate);
+				}
+				harmonic += (h == 0 ? 1.0 : 2.0) * (re * re + im * im) / len;
+			}
+			Scenario scenario = {setting.label, "Clipper", "Audio In", SIGNAL_AUDIO, state, NULL};
+			printf(" %10.1f %9.2f", 10.0 * std::log10(std::max(total - harmonic, 1e-30) / harmonic), measure(model, scenario, PORT_MAX_CHANNELS, sampleRate, samples));
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+}
+
+// Antiderivative anti-aliasing of Clipper while the threshold moves: an input sitting on the upper threshold, 5V, crosses it
+// back and forth by 1mV at 5 Hz, as the threshold CV moves it by 0.1V at 997 Hz. The breakpoint then moves between the inputs,
+// which is where dividing by their distance breaks down. The largest output must stay close to the threshold
+static void measureMovingThreshold(Model *model)
+{
+	static const char *methods[] = {"Clip", "Fold", "Multi"};
+	const float sampleRate = 48000.f;
+	Module::ProcessArgs args;
+	char state[96];
+	float peak, out;
+
+	printf("\nClipper with a moving threshold, 5V +/- 1mV at 5 Hz against 5V +/- 0.1V at 997 Hz at %.1fk: largest output in V\n\n", sampleRate / 1000.f);
+	printf("%-22s", "Anti-aliasing");
+	for (const char *method : methods)
+		printf(" %10s", method);
+	printf("\n");
+
+	args.sampleRate = sampleRate;
+	args.sampleTime = 1.f / sampleRate;
+	for (int antiAliasing = 1; antiAliasing <= 2; antiAliasing++)
+	{
+		printf("%-22s", antiAliasing == 1 ? "ADAA 1st" : "ADAA 2nd");
+		for (int method = 0; method < 3; method++)
+		{
+			Module *module = model->createModule();
+			Input &input = module->getInput(findInput(module, "Audio In"));
+			Input &cv = module->getInput(findInput(module, "Upper Threshold Modulation"));
+
+			snprintf(state, sizeof(state), "{\"Clip Method\": %d, \"Polarity\": 1, \"Anti-aliasing\": %d}", method, antiAliasing);
+			json_t *stateJ = parseState(state);
+			module->dataFromJson(stateJ);
+			json_decref(stateJ);
+			setParams(module, "Attenuation for Upper", 1.f);
+			input.channels = 1;
+			cv.channels = 1;
+			module->outputs[0].channels = 1;
+
+			peak = 0.f;
+			for (int s = 0; s < (int)sampleRate; s++, args.frame++)
+			{
+				input.voltages[0] = 5.f + 0.001f * std::sin(2.0 * M_PI * 5.0 * s / sampleRate);
+				cv.voltages[0] = 0.1f * std::sin(2.0 * M_PI * 997.0 * s / sampleRate);
+				module->process(args);
+				out = std::fabs(module->outputs[0].voltages[0]);
+				if (std::isnan(out) || out > peak)
+					peak = out; // Once NaN it stays, as nothing compares greater
+			}
+			delete module;
+			printf(" %10.4f", peak);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Plugin plugin;
+	long samples = 1000000;
+	const char *filter = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			samples = atol(argv[++i]);
+		else
+			filter = argv[i];
+	}
+
+	init(&plugin);
+
+	printf("ns/sample, %ld samples per measurement\n\n", samples);
+	printf("%-22s %3s", "Module", "ch");
+	for (float sampleRate : sampleRates)
+		printf(" %9.1fk", sampleRate / 1000.f);
+	printf("\n");
+
+	for (const Scenario &scenario : scenarios)
+	{
+		if (filter && !strstr(scenario.label, filter))
+			continue;
+
+		Model *model = findModel(&plugin, scenario.slug);
+		if (!model)
+		{
+			fprintf(stderr, "Model %s not found\n", scenario.slug);
+			return 1;
+		}
+
+		for (int channels : channelCounts)
+		{
+			// Modules without a polyphonic input only have the unpatched measurement
+			if (!scenario.polyInput && channels > 0)
+				continue;
+
+			printf("%-22s %3d", scenario.label, channels);
+			for (float sampleRate : sampleRates)
+			{
+				printf(" %10.2f", measure(model, scenario, channels, sampleRate, samples));
+				fflush(stdout);
+			}
+			printf("\n");
+		}
+	}
+
+	if (!filter || strstr("Interpolation", filter))
+		measureInterpolation(samples);
+
+	if (!filter || strstr("Harmoblender Pitch", filter))
+		measurePitch(findModel(&plugin, "Harmoblender"), samples);
+
+	if (!filter || strstr("Saturation", filter))
+		measureSaturation(samples);
+
+	if (!filter || strstr("Clipper Aliasing", filter))
+		measureAliasing(findModel(&plugin, "Clipper"), samples);
+
+	if (!filter || strstr("Clipper Moving Threshold", filter))
+		measureMovingThreshold(findModel(&plugin, "Clipper"));
+
+	return 0;
+}
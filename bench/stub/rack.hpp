@@ -0,0 +1,1352 @@
+#pragma once
+
+// Minimal stand-in for the VCV Rack 2 SDK, just enough to compile the modules in src/ and drive their process() functions
+// outside of Rack. The engine side (Module, Param, Port, Light, dsp) mirrors the Rack semantics the modules rely on.
+// The UI side (widgets, menus, NanoVG) only has to compile: widgets are constructed by nobody and all drawing calls are no-ops.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdarg>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <x86intrin.h>
+
+// Helper used by all modules to declare a range of enum values
+#define ENUMS(name, count) name, name##_LAST = name + (count) - 1
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Jansson-like JSON values, only the calls used for module state
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+struct json_t
+{
+	enum Type
+	{
+		OBJECT,
+		ARRAY,
+		STRING,
+		INTEGER,
+		REAL,
+		TRUE,
+		FALSE,
+		NUL
+	};
+	Type type = NUL;
+	long long integer = 0;
+	double real = 0.0;
+	std::string string;
+	std::vector<std::pair<std::string, json_t *>> object;
+	std::vector<json_t *> array;
+	int refcount = 1;
+};
+
+inline json_t *json_incref(json_t *json)
+{
+	if (json)
+		json->refcount++;
+	return json;
+}
+
+inline void json_decref(json_t *json)
+{
+	if (!json || --json->refcount > 0)
+		return;
+	for (auto &kv : json->object)
+		json_decref(kv.second);
+	for (json_t *j : json->array)
+		json_decref(j);
+	delete json;
+}
+
+inline json_t *json_new(json_t::Type type)
+{
+	json_t *json = new json_t;
+	json->type = type;
+	return json;
+}
+
+inline json_t *json_object() { return json_new(json_t::OBJECT); }
+inline json_t *json_array() { return json_new(json_t::ARRAY); }
+inline json_t *json_null() { return json_new(json_t::NUL); }
+inline json_t *json_true() { return json_new(json_t::TRUE); }
+inline json_t *json_false() { return json_new(json_t::FALSE); }
+inline json_t *json_boolean(bool b) { return json_new(b ? json_t::TRUE : json_t::FALSE); }
+
+inline json_t *json_integer(long long i)
+{
+	json_t *json = json_new(json_t::INTEGER);
+	json->integer = i;
+	return json;
+}
+
+inline json_t *json_real(double r)
+{
+	json_t *json = json_new(json_t::REAL);
+	json->real = r;
+	return json;
+}
+
+inline json_t *json_string(const char *s)
+{
+	json_t *json = json_new(json_t::STRING);
+	json->string = s;
+	return json;
+}
+
+inline int json_object_set_new(json_t *object, const char *key, json_t *value)
+{
+	for (auto &kv : object->object)
+	{
+		if (kv.first == key)
+		{
+			json_decref(kv.second);
+			kv.second = value;
+			return 0;
+		}
+	}
+	object->object.push_back(std::make_pair(std::string(key), value));
+	return 0;
+}
+
+inline int json_object_set(json_t *object, const char *key, json_t *value) { return json_object_set_new(object, key, json_incref(value)); }
+
+inline json_t *json_object_get(const json_t *object, const char *key)
+{
+	if (!object || object->type != json_t::OBJECT)
+		return NULL;
+	for (auto &kv : object->object)
+		if (kv.first == key)
+			return kv.second;
+	return NULL;
+}
+
+inline int json_array_append_new(json_t *array, json_t *value)
+{
+	array->array.push_back(value);
+	return 0;
+}
+
+inline size_t json_array_size(const json_t *array) { return (array && array->type == json_t::ARRAY) ? array->array.size() : 0; }
+inline json_t *json_array_get(const json_t *array, size_t index) { return index < json_array_size(array) ? array->array[index] : NULL; }
+inline bool json_is_array(const json_t *json) { return json && json->type == json_t::ARRAY; }
+
+inline long long json_integer_value(const json_t *json) { return (json && json->type == json_t::INTEGER) ? json->integer : 0; }
+inline double json_real_value(const json_t *json) { return (json && json->type == json_t::REAL) ? json->real : 0.0; }
+inline double json_number_value(const json_t *json)
+{
+	if (!json)
+		return 0.0;
+	if (json->type == json_t::INTEGER)
+		return (double)json->integer;
+	if (json->type == json_t::REAL)
+		return json->real;
+	return 0.0;
+}
+inline const char *json_string_value(const json_t *json) { return (json && json->type == json_t::STRING) ? json->string.c_str() : NULL; }
+inline bool json_is_true(const json_t *json) { return json && json->type == json_t::TRUE; }
+inline bool json_boolean_value(const json_t *json) { return json_is_true(json); }
+
+#define json_array_foreach(array, index, value) \
+	for (index = 0; index < json_array_size(array) && (value = json_array_get(array, index)); index++)
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// NanoVG, all no-ops
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+struct NVGcontext;
+
+struct NVGcolor
+{
+	float r, g, b, a;
+};
+
+enum NVGalign
+{
+	NVG_ALIGN_LEFT = 1 << 0,
+	NVG_ALIGN_CENTER = 1 << 1,
+	NVG_ALIGN_RIGHT = 1 << 2,
+	NVG_ALIGN_TOP = 1 << 3,
+	NVG_ALIGN_MIDDLE = 1 << 4,
+	NVG_ALIGN_BOTTOM = 1 << 5,
+	NVG_ALIGN_BASELINE = 1 << 6,
+};
+
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) { return NVGcolor{r / 255.f, g / 255.f, b / 255.f, a / 255.f}; }
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) { return nvgRGBA(r, g, b, 255); }
+inline void nvgBeginPath(NVGcontext *) {}
+inline void nvgRect(NVGcontext *, float, float, float, float) {}
+inline void nvgRoundedRect(NVGcontext *, float, float, float, float, float) {}
+inline void nvgFillColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokeColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokeWidth(NVGcontext *, float) {}
+inline void nvgFill(NVGcontext *) {}
+inline void nvgStroke(NVGcontext *) {}
+inline void nvgMoveTo(NVGcontext *, float, float) {}
+inline void nvgLineTo(NVGcontext *, float, float) {}
+inline void nvgFontFaceId(NVGcontext *, int) {}
+inline void nvgFontSize(NVGcontext *, float) {}
+inline void nvgTextLetterSpacing(NVGcontext *, float) {}
+inline void nvgTextAlign(NVGcontext *, int) {}
+inline float nvgText(NVGcontext *, float x, float, const char *, const char *) { return x; }
+
+namespace rack
+{
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Utilities
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+#define CHECKMARK_STRING "\xE2\x9C\x94"
+#define CHECKMARK(_cond) ((_cond) ? CHECKMARK_STRING : "")
+
+	namespace string
+	{
+		inline std::string f(const char *format, ...)
+		{
+			char buf[1024];
+			va_list args;
+			va_start(args, format);
+			vsnprintf(buf, sizeof(buf), format, args);
+			va_end(args);
+			return buf;
+		}
+	} // namespace string
+
+	namespace random
+	{
+		// xoroshiro128+ as in Rack, seeded with a fixed value so benchmark runs are reproducible
+		inline uint64_t &state(int i)
+		{
+			static uint64_t s[2] = {0x9E3779B97F4A7C15ull, 0xBF58476D1CE4E5B9ull};
+			return s[i];
+		}
+
+		inline uint64_t u64()
+		{
+			uint64_t s0 = state(0), s1 = state(1);
+			uint64_t result = s0 + s1;
+			s1 ^= s0;
+			state(0) = ((s0 << 55) | (s0 >> 9)) ^ s1 ^ (s1 << 14);
+			state(1) = (s1 << 36) | (s1 >> 28);
+			return result;
+		}
+
+		inline uint32_t u32() { return u64() >> 32; }
+		inline float uniform() { return (u32() >> 8) * (1.f / 16777216.f); }
+	} // namespace random
+
+	namespace math
+	{
+		struct Vec
+		{
+			float x = 0.f;
+			float y = 0.f;
+
+			Vec() {}
+			Vec(float xy) : x(xy), y(xy) {}
+			Vec(float x, float y) : x(x), y(y) {}
+
+			Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+			Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+			Vec mult(float s) const { return Vec(x * s, y * s); }
+			Vec div(float s) const { return Vec(x / s, y / s); }
+		};
+
+		struct Rect
+		{
+			Vec pos;
+			Vec size;
+		};
+
+		inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+		inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+		inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+		inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+		inline bool isPow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
+	} // namespace math
+
+	using namespace math;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// SIMD vectors, SSE backed and with the same operators and functions as rack::simd
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	namespace simd
+	{
+		template <typename T, int N>
+		struct Vector;
+
+		template <>
+		struct Vector<float, 4>
+		{
+			using type = float;
+			constexpr static int size = 4;
+
+			union
+			{
+				__m128 v;
+				float s[4];
+			};
+
+			Vector() = default;
+			Vector(__m128 v) : v(v) {}
+			Vector(float x) { v = _mm_set1_ps(x); }
+			Vector(float x1, float x2, float x3, float x4) { v = _mm_setr_ps(x1, x2, x3, x4); }
+			static Vector zero() { return Vector(_mm_setzero_ps()); }
+			static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+			static Vector load(const float *x) { return Vector(_mm_loadu_ps(x)); }
+			void store(float *x) { _mm_storeu_ps(x, v); }
+			float &operator[](int i) { return s[i]; }
+			const float &operator[](int i) const { return s[i]; }
+			// Converts from int32 lanes
+			Vector(Vector<int32_t, 4> a);
+			// Reinterprets the bits of int32 lanes
+			static Vector cast(Vector<int32_t, 4> a);
+		};
+
+		template <>
+		struct Vector<int32_t, 4>
+		{
+			using type = int32_t;
+			constexpr static int size = 4;
+
+			union
+			{
+				__m128i v;
+				int32_t s[4];
+			};
+
+			Vector() = default;
+			Vector(__m128i v) : v(v) {}
+			Vector(int32_t x) { v = _mm_set1_epi32(x); }
+			Vector(int32_t x1, int32_t x2, int32_t x3, int32_t x4) { v = _mm_setr_epi32(x1, x2, x3, x4); }
+			static Vector zero() { return Vector(_mm_setzero_si128()); }
+			static Vector mask() { return Vector(_mm_set1_epi32(-1)); }
+			static Vector load(const int32_t *x) { return Vector(_mm_loadu_si128((const __m128i *)x)); }
+			void store(int32_t *x) { _mm_storeu_si128((__m128i *)x, v); }
+			int32_t &operator[](int i) { return s[i]; }
+			const int32_t &operator[](int i) const { return s[i]; }
+			// Converts from float lanes, truncating
+			Vector(Vector<float, 4> a);
+			// Reinterprets the bits of float lanes
+			static Vector cast(Vector<float, 4> a);
+		};
+
+		inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) { v = _mm_cvtepi32_ps(a.v); }
+		inline Vector<int32_t, 4>::Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+		inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) { return Vector(_mm_castsi128_ps(a.v)); }
+		inline Vector<int32_t, 4> Vector<int32_t, 4>::cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+
+		typedef Vector<float, 4> float_4;
+		typedef Vector<int32_t, 4> int32_4;
+
+#define STUB_SIMD_INFIX(T, OP, FN)                                               \
+	inline T operator OP(const T &a, const T &b) { return T(FN(a.v, b.v)); }     \
+	inline T operator OP(const T::type &a, const T &b) { return T(a) OP b; }     \
+	inline T operator OP(const T &a, const T::type &b) { return a OP T(b); }     \
+	inline T &operator OP##=(T &a, const T &b) { return a = a OP b; }            \
+	inline T &operator OP##=(T &a, const T::type &b) { return a = a OP T(b); }
+
+		STUB_SIMD_INFIX(float_4, +, _mm_add_ps)
+		STUB_SIMD_INFIX(float_4, -, _mm_sub_ps)
+		STUB_SIMD_INFIX(float_4, *, _mm_mul_ps)
+		STUB_SIMD_INFIX(float_4, /, _mm_div_ps)
+		STUB_SIMD_INFIX(float_4, &, _mm_and_ps)
+		STUB_SIMD_INFIX(float_4, |, _mm_or_ps)
+		STUB_SIMD_INFIX(float_4, ^, _mm_xor_ps)
+		STUB_SIMD_INFIX(int32_4, +, _mm_add_epi32)
+		STUB_SIMD_INFIX(int32_4, -, _mm_sub_epi32)
+		STUB_SIMD_INFIX(int32_4, *, _mm_mullo_epi32)
+		STUB_SIMD_INFIX(int32_4, &, _mm_and_si128)
+		STUB_SIMD_INFIX(int32_4, |, _mm_or_si128)
+		STUB_SIMD_INFIX(int32_4, ^, _mm_xor_si128)
+#undef STUB_SIMD_INFIX
+
+#define STUB_SIMD_COMPARE(T, OP, EXPR)                                            \
+	inline T operator OP(const T &a, const T &b) { return T(EXPR); }              \
+	inline T operator OP(const T::type &a, const T &b) { return T(a) OP b; }      \
+	inline T operator OP(const T &a, const T::type &b) { return a OP T(b); }
+
+		STUB_SIMD_COMPARE(float_4, ==, _mm_cmpeq_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(float_4, !=, _mm_cmpneq_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(float_4, <, _mm_cmplt_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(float_4, <=, _mm_cmple_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(float_4, >, _mm_cmpgt_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(float_4, >=, _mm_cmpge_ps(a.v, b.v))
+		STUB_SIMD_COMPARE(int32_4, ==, _mm_cmpeq_epi32(a.v, b.v))
+		STUB_SIMD_COMPARE(int32_4, <, _mm_cmplt_epi32(a.v, b.v))
+		STUB_SIMD_COMPARE(int32_4, >, _mm_cmpgt_epi32(a.v, b.v))
+#undef STUB_SIMD_COMPARE
+
+		inline float_4 operator-(const float_4 &a) { return 0.f - a; }
+		inline int32_4 operator-(const int32_4 &a) { return 0 - a; }
+		inline float_4 operator~(const float_4 &a) { return a ^ float_4::mask(); }
+		inline int32_4 operator~(const int32_4 &a) { return a ^ int32_4::mask(); }
+		// Shifts are arithmetic to the right, as in Rack
+		inline int32_4 operator<<(const int32_4 &a, const int &b) { return int32_4(_mm_slli_epi32(a.v, b)); }
+		inline int32_4 operator>>(const int32_4 &a, const int &b) { return int32_4(_mm_srai_epi32(a.v, b)); }
+
+		inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return float_4(_mm_blendv_ps(b.v, a.v, mask.v)); }
+		inline int32_4 ifelse(int32_4 mask, int32_4 a, int32_4 b) { return (a & mask) | int32_4(_mm_andnot_si128(mask.v, b.v)); }
+		inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+		inline int movemask(int32_4 a) { return _mm_movemask_ps(_mm_castsi128_ps(a.v)); }
+
+		inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+		inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+		inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+		inline float_4 fabs(float_4 x) { return x & float_4::cast(int32_4(0x7fffffff)); }
+		inline float_4 floor(float_4 a) { return float_4(_mm_floor_ps(a.v)); }
+		inline float_4 ceil(float_4 a) { return float_4(_mm_ceil_ps(a.v)); }
+		inline float_4 round(float_4 a) { return float_4(_mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); }
+		inline float_4 trunc(float_4 a) { return float_4(_mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)); }
+		inline float_4 sqrt(float_4 a) { return float_4(_mm_sqrt_ps(a.v)); }
+		inline float_4 crossfade(float_4 a, float_4 b, float_4 p) { return a + (b - a) * p; }
+
+		// Scalar versions, so templates work for float and float_4 alike
+		inline float ifelse(bool cond, float a, float b) { return cond ? a : b; }
+		inline float floor(float a) { return std::floor(a); }
+		inline float round(float a) { return std::round(a); }
+		inline float fabs(float a) { return std::fabs(a); }
+		inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+	} // namespace simd
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// DSP helpers
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	namespace dsp
+	{
+		static const float FREQ_C4 = 261.6256f;
+		static const float FREQ_A4 = 440.0000f;
+
+		// 2^xi for a whole number xi, by building the float exponent
+		inline float approxExp2_int(float xi) { return std::ldexp(1.f, (int)xi); }
+		inline simd::float_4 approxExp2_int(simd::float_4 xi) { return simd::float_4::cast((simd::int32_4(xi) + 127) << 23); }
+
+		// Returns 2^x with a 5th order polynomial for the fraction, as Rack's approximation
+		template <typename T>
+		T approxExp2_taylor5(T x)
+		{
+			T xi = simd::floor(x);
+			T xf = x - xi;
+			T yf = 1.f + xf * (0.69315308f + xf * (0.24015361f + xf * (0.05582631f + xf * (0.00898934f + xf * 0.00187757f))));
+			return yf * approxExp2_int(xi);
+		}
+
+		struct SchmittTrigger
+		{
+			bool state = true;
+
+			void reset() { state = true; }
+
+			bool process(float in, float lowThreshold = 0.f, float highThreshold = 1.f)
+			{
+				if (state)
+				{
+					if (in <= lowThreshold)
+						state = false;
+				}
+				else if (in >= highThreshold)
+				{
+					state = true;
+					return true;
+				}
+				return false;
+			}
+
+			bool isHigh() { return state; }
+		};
+
+		struct BooleanTrigger
+		{
+			bool state = true;
+
+			void reset() { state = true; }
+
+			bool process(bool in)
+			{
+				bool triggered = (in && !state);
+				state = in;
+				return triggered;
+			}
+		};
+
+		struct PulseGenerator
+		{
+			float remaining = 0.f;
+
+			void reset() { remaining = 0.f; }
+
+			bool process(float deltaTime)
+			{
+				if (remaining > 0.f)
+				{
+					remaining -= deltaTime;
+					return true;
+				}
+				return false;
+			}
+
+			void trigger(float duration = 1e-3f)
+			{
+				if (duration > remaining)
+					remaining = duration;
+			}
+		};
+
+		// Real FFT with the output order of Rack's pffft wrapper: DC and Nyquist in the first two floats, then the real and
+		// imaginary part of each bin. Unscaled, forward transform only. A plain radix-2 FFT, the length must be a power of 2
+		struct RealFFT
+		{
+			size_t length;
+			std::vector<double> re, im;
+
+			RealFFT(size_t length) : length(length), re(length), im(length) {}
+
+			void rfft(const float *input, float *output)
+			{
+				size_t i, j, k, m, bit;
+				double wr, wi, tr, ti, ur, ui;
+
+				for (i = 0, j = 0; i < length; i++)
+				{
+					re[j] = input[i];
+					im[j] = 0.0;
+					for (bit = length >> 1; bit && (j & bit); bit >>= 1)
+						j ^= bit;
+					j |= bit;
+				}
+				for (m = 2; m <= length; m <<= 1)
+				{
+					for (k = 0; k < m / 2; k++)
+					{
+						wr = std::cos(-2.0 * M_PI * k / m);
+						wi = std::sin(-2.0 * M_PI * k / m);
+						for (i = k; i < length; i += m)
+						{
+							j = i + m / 2;
+							tr = wr * re[j] - wi * im[j];
+							ti = wr * im[j] + wi * re[j];
+							ur = re[i];
+							ui = im[i];
+							re[i] = ur + tr;
+							im[i] = ui + ti;
+							re[j] = ur - tr;
+							im[j] = ui - ti;
+						}
+					}
+				}
+				output[0] = re[0];
+				output[1] = re[length / 2];
+				for (k = 1; k < length / 2; k++)
+				{
+					output[2 * k] = re[k];
+					output[2 * k + 1] = im[k];
+				}
+			}
+		};
+	} // namespace dsp
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Engine
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	static const int PORT_MAX_CHANNELS = 16;
+
+	struct Module;
+	struct Model;
+	struct Plugin;
+
+	struct Param
+	{
+		float value = 0.f;
+
+		float getValue() { return value; }
+		void setValue(float value) { this->value = value; }
+	};
+
+	struct Port
+	{
+		float voltages[PORT_MAX_CHANNELS] = {};
+		int channels = 0;
+
+		void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+		float getVoltage(int channel = 0) { return voltages[channel]; }
+		float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+		float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+		float getNormalPolyVoltage(float normalVoltage, int channel) { return isConnected() ? getPolyVoltage(channel) : normalVoltage; }
+		float *getVoltages(int firstChannel = 0) { return &voltages[firstChannel]; }
+
+		template <typename T>
+		T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+		template <typename T>
+		T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(firstChannel); }
+		template <typename T>
+		void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+
+		void readVoltages(float *v)
+		{
+			for (int c = 0; c < channels; c++)
+				v[c] = voltages[c];
+		}
+
+		void writeVoltages(const float *v)
+		{
+			for (int c = 0; c < channels; c++)
+				voltages[c] = v[c];
+		}
+
+		void clearVoltages()
+		{
+			for (int c = 0; c < channels; c++)
+				voltages[c] = 0.f;
+		}
+
+		float getVoltageSum()
+		{
+			float sum = 0.f;
+			for (int c = 0; c < channels; c++)
+				sum += voltages[c];
+			return sum;
+		}
+
+		// Same contract as Rack: an unconnected port stays at 0 channels, a connected port never drops below 1 channel
+		void setChannels(int channels)
+		{
+			if (this->channels == 0)
+				return;
+			for (int c = channels; c < this->channels; c++)
+				voltages[c] = 0.f;
+			if (channels == 0)
+				channels = 1;
+			this->channels = channels;
+		}
+
+		int getChannels() { return channels; }
+		bool isConnected() { return channels > 0; }
+		bool isMonophonic() { return channels == 1; }
+		bool isPolyphonic() { return channels > 1; }
+	};
+
+	struct Input : Port
+	{
+	};
+
+	struct Output : Port
+	{
+	};
+
+	struct Light
+	{
+		float value = 0.f;
+
+		void setBrightness(float brightness) { value = brightness; }
+		float getBrightness() { return value; }
+		void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) { value += (brightness - value) * lambda * deltaTime; }
+	};
+
+	struct ParamQuantity
+	{
+		Module *module = NULL;
+		int paramId = -1;
+		float minValue = 0.f;
+		float maxValue = 1.f;
+		float defaultValue = 0.f;
+		std::string name;
+		std::string unit;
+		bool snapEnabled = false;
+		bool smoothEnabled = false;
+		bool randomizeEnabled = true;
+
+		virtual ~ParamQuantity() {}
+		Param *getParam();
+		void setValue(float value);
+		float getValue();
+	};
+
+	struct PortInfo
+	{
+		std::string name;
+	};
+
+	struct LightInfo
+	{
+		std::string name;
+	};
+
+	struct Module
+	{
+		int64_t id = -1;
+		Model *model = NULL;
+
+		std::vector<Param> params;
+		std::vector<Input> inputs;
+		std::vector<Output> outputs;
+		std::vector<Light> lights;
+		std::vector<ParamQuantity *> paramQuantities;
+		std::vector<PortInfo *> inputInfos;
+		std::vector<PortInfo *> outputInfos;
+		std::vector<LightInfo *> lightInfos;
+
+		struct Expander
+		{
+			int64_t moduleId = -1;
+			Module *module = NULL;
+			void *producerMessage = NULL;
+			void *consumerMessage = NULL;
+			bool messageFlipRequested = false;
+
+			void requestMessageFlip() { messageFlipRequested = true; }
+		};
+
+		Expander leftExpander;
+		Expander rightExpander;
+
+		struct ProcessArgs
+		{
+			float sampleRate;
+			float sampleTime;
+			int64_t frame;
+		};
+
+		struct SampleRateChangeEvent
+		{
+			float sampleRate;
+			float sampleTime;
+		};
+
+		struct ExpanderChangeEvent
+		{
+			uint8_t side;
+		};
+
+		Module() {}
+
+		virtual ~Module()
+		{
+			for (ParamQuantity *pq : paramQuantities)
+				delete pq;
+			for (PortInfo *pi : inputInfos)
+				delete pi;
+			for (PortInfo *pi : outputInfos)
+				delete pi;
+			for (LightInfo *li : lightInfos)
+				delete li;
+		}
+
+		void config(int numParams, int numInputs, int numOutputs, int numLights = 0)
+		{
+			params.resize(numParams);
+			inputs.resize(numInputs);
+			outputs.resize(numOutputs);
+			lights.resize(numLights);
+			paramQuantities.resize(numParams, NULL);
+			inputInfos.resize(numInputs, NULL);
+			outputInfos.resize(numOutputs, NULL);
+			lightInfos.resize(numLights, NULL);
+		}
+
+		template <class TParamQuantity = ParamQuantity>
+		TParamQuantity *configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "",
+									float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f)
+		{
+			delete paramQuantities[paramId];
+			TParamQuantity *q = new TParamQuantity;
+			q->module = this;
+			q->paramId = paramId;
+			q->minValue = minValue;
+			q->maxValue = maxValue;
+			q->defaultValue = defaultValue;
+			q->name = name;
+			q->unit = unit;
+			paramQuantities[paramId] = q;
+			params[paramId].value = defaultValue;
+			return q;
+		}
+
+		template <class TParamQuantity = ParamQuantity>
+		TParamQuantity *configButton(int paramId, std::string name = "")
+		{
+			return configParam<TParamQuantity>(paramId, 0.f, 1.f, 0.f, name);
+		}
+
+		template <class TParamQuantity = ParamQuantity>
+		TParamQuantity *configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {})
+		{
+			TParamQuantity *q = configParam<TParamQuantity>(paramId, minValue, maxValue, defaultValue, name);
+			q->snapEnabled = true;
+			return q;
+		}
+
+		PortInfo *configInput(int portId, std::string name = "")
+		{
+			delete inputInfos[portId];
+			inputInfos[portId] = new PortInfo;
+			inputInfos[portId]->name = name;
+			return inputInfos[portId];
+		}
+
+		PortInfo *configOutput(int portId, std::string name = "")
+		{
+			delete outputInfos[portId];
+			outputInfos[portId] = new PortInfo;
+			outputInfos[portId]->name = name;
+			return outputInfos[portId];
+		}
+
+		LightInfo *configLight(int lightId, std::string name = "")
+		{
+			delete lightInfos[lightId];
+			lightInfos[lightId] = new LightInfo;
+			lightInfos[lightId]->name = name;
+			return lightInfos[lightId];
+		}
+
+		Param &getParam(int index) { return params[index]; }
+		Input &getInput(int index) { return inputs[index]; }
+		Output &getOutput(int index) { return outputs[index]; }
+		Light &getLight(int index) { return lights[index]; }
+		ParamQuantity *getParamQuantity(int index) { return paramQuantities[index]; }
+		int getNumParams() { return params.size(); }
+		int getNumInputs() { return inputs.size(); }
+		int getNumOutputs() { return outputs.size(); }
+		int getNumLights() { return lights.size(); }
+		Expander &getLeftExpander() { return leftExpander; }
+		Expander &getRightExpander() { return rightExpander; }
+
+		virtual void process(const ProcessArgs &args) {}
+		virtual void onReset() {}
+		virtual void onRandomize() {}
+		virtual void onAdd() {}
+		virtual void onRemove() {}
+		virtual void onSampleRateChange() {}
+		virtual void onSampleRateChange(const SampleRateChangeEvent &e) { onSampleRateChange(); }
+		virtual void onExpanderChange(const ExpanderChangeEvent &e) {}
+		virtual json_t *dataToJson() { return NULL; }
+		virtual void dataFromJson(json_t *rootJ) {}
+	};
+
+	inline Param *ParamQuantity::getParam() { return module ? &module->params[paramId] : NULL; }
+	inline void ParamQuantity::setValue(float value)
+	{
+		if (module)
+			module->params[paramId].setValue(value);
+	}
+	inline float ParamQuantity::getValue() { return module ? module->params[paramId].getValue() : defaultValue; }
+
+	namespace engine
+	{
+		using rack::Input;
+		using rack::Light;
+		using rack::Module;
+		using rack::Output;
+		using rack::Param;
+		using rack::ParamQuantity;
+		using rack::Port;
+	} // namespace engine
+
+	// Engine services queried by modules outside of process(). The benchmark driver sets the sample rate before each run
+	struct Engine
+	{
+		float sampleRate = 44100.f;
+
+		float getSampleRate() { return sampleRate; }
+		float getSampleTime() { return 1.f / sampleRate; }
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Widgets, UI & components. These only need to compile
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	static const float RACK_GRID_WIDTH = 15;
+	static const float RACK_GRID_HEIGHT = 380;
+
+	inline Vec mm2px(Vec mm) { return mm.mult(75.f / 25.4f); }
+
+	struct Font
+	{
+		int handle = -1;
+	};
+
+	struct Window
+	{
+		std::shared_ptr<Font> loadFont(const std::string &filename) { return NULL; }
+	};
+
+	struct Context
+	{
+		Window *window = NULL;
+		Engine *engine = NULL;
+
+		Context() : window(new Window), engine(new Engine) {}
+	};
+
+	inline Context *contextGet()
+	{
+		static Context context;
+		return &context;
+	}
+
+#define APP rack::contextGet()
+
+	struct Widget
+	{
+		Rect box;
+		Widget *parent = NULL;
+		std::vector<Widget *> children;
+		bool visible = true;
+
+		struct DrawArgs
+		{
+			NVGcontext *vg = NULL;
+			Rect clipBox;
+		};
+
+		virtual ~Widget()
+		{
+			for (Widget *child : children)
+				delete child;
+		}
+
+		void addChild(Widget *child)
+		{
+			child->parent = this;
+			children.push_back(child);
+		}
+
+		virtual void step()
+		{
+			for (Widget *child : children)
+				child->step();
+		}
+
+		virtual void draw(const DrawArgs &args) {}
+		virtual void drawLayer(const DrawArgs &args, int layer) {}
+	};
+
+	struct OpaqueWidget : Widget
+	{
+	};
+
+	struct TransparentWidget : Widget
+	{
+	};
+
+	struct SvgPanel : Widget
+	{
+		SvgPanel() { box.size = Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT); }
+	};
+
+	struct ParamWidget : OpaqueWidget
+	{
+		Module *module = NULL;
+		int paramId = -1;
+
+		ParamQuantity *getParamQuantity() { return module ? module->paramQuantities[paramId] : NULL; }
+	};
+
+	struct Knob : ParamWidget
+	{
+	};
+
+	struct SvgKnob : Knob
+	{
+	};
+
+	struct SvgSwitch : ParamWidget
+	{
+		bool momentary = false;
+	};
+
+	struct PortWidget : OpaqueWidget
+	{
+		Module *module = NULL;
+		int portId = -1;
+	};
+
+	struct SvgPort : PortWidget
+	{
+	};
+
+	struct LightWidget : TransparentWidget
+	{
+		NVGcolor bgColor = {};
+		NVGcolor color = {};
+		NVGcolor borderColor = {};
+	};
+
+	struct ModuleLightWidget : LightWidget
+	{
+		Module *module = NULL;
+		int firstLightId = -1;
+		std::vector<NVGcolor> baseColors;
+
+		void addBaseColor(NVGcolor baseColor) { baseColors.push_back(baseColor); }
+	};
+
+	struct GrayModuleLightWidget : ModuleLightWidget
+	{
+	};
+
+	template <typename TBase = GrayModuleLightWidget>
+	struct TRedLight : TBase
+	{
+	};
+	using RedLight = TRedLight<>;
+
+	template <typename TBase>
+	struct SmallLight : TBase
+	{
+	};
+
+	template <typename TBase>
+	struct MediumLight : TBase
+	{
+	};
+
+	template <typename TBase>
+	struct LargeLight : TBase
+	{
+	};
+
+	template <typename TBase>
+	struct SmallSimpleLight : TBase
+	{
+	};
+
+	template <typename TBase>
+	struct MediumSimpleLight : TBase
+	{
+	};
+
+	template <typename TLight>
+	struct VCVLightButton : SvgSwitch
+	{
+		TLight *light;
+
+		VCVLightButton()
+		{
+			momentary = true;
+			light = new TLight;
+			addChild(light);
+		}
+
+		TLight *getLight() { return light; }
+	};
+
+	template <typename TLight>
+	struct VCVLightLatch : VCVLightButton<TLight>
+	{
+	};
+
+	struct ScrewSilver : Widget
+	{
+	};
+
+	struct RoundBlackKnob : SvgKnob
+	{
+	};
+
+	struct RoundSmallBlackKnob : RoundBlackKnob
+	{
+	};
+
+	struct RoundLargeBlackKnob : RoundBlackKnob
+	{
+	};
+
+	struct Trimpot : SvgKnob
+	{
+	};
+
+	struct CKSS : SvgSwitch
+	{
+	};
+
+	struct PJ301MPort : SvgPort
+	{
+	};
+
+	struct Menu;
+
+	struct MenuEntry : OpaqueWidget
+	{
+	};
+
+	struct MenuSeparator : MenuEntry
+	{
+	};
+
+	struct MenuLabel : MenuEntry
+	{
+		std::string text;
+	};
+
+	struct MenuItem : MenuEntry
+	{
+		std::string text;
+		std::string rightText;
+		bool disabled = false;
+
+		virtual Menu *createChildMenu() { return NULL; }
+	};
+
+	struct Menu : OpaqueWidget
+	{
+	};
+
+	struct ModuleWidget : OpaqueWidget
+	{
+		Model *model = NULL;
+		Module *module = NULL;
+		Widget *panel = NULL;
+
+		void setModule(Module *module) { this->module = module; }
+
+		void setPanel(Widget *panel)
+		{
+			this->panel = panel;
+			addChild(panel);
+			box.size = panel->box.size;
+		}
+
+		template <class TModule>
+		TModule *getModule() { return dynamic_cast<TModule *>(module); }
+
+		void addParam(ParamWidget *param) { addChild(param); }
+		void addInput(PortWidget *input) { addChild(input); }
+		void addOutput(PortWidget *output) { addChild(output); }
+
+		virtual void appendContextMenu(Menu *menu) {}
+	};
+
+	namespace app
+	{
+		using rack::Knob;
+		using rack::LightWidget;
+		using rack::ModuleLightWidget;
+		using rack::ModuleWidget;
+		using rack::ParamWidget;
+		using rack::PortWidget;
+		using rack::SvgKnob;
+		using rack::SvgPanel;
+		using rack::SvgPort;
+		using rack::SvgSwitch;
+	} // namespace app
+
+	namespace widget
+	{
+		using rack::OpaqueWidget;
+		using rack::TransparentWidget;
+		using rack::Widget;
+	} // namespace widget
+
+	namespace ui
+	{
+		using rack::Menu;
+		using rack::MenuEntry;
+		using rack::MenuItem;
+		using rack::MenuLabel;
+		using rack::MenuSeparator;
+	} // namespace ui
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Plugin & Model
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	struct Model
+	{
+		Plugin *plugin = NULL;
+		std::string slug;
+
+		virtual ~Model() {}
+		virtual Module *createModule() = 0;
+		virtual ModuleWidget *createModuleWidget(Module *m) = 0;
+	};
+
+	struct Plugin
+	{
+		std::string slug;
+		std::vector<Model *> models;
+
+		void addModel(Model *model)
+		{
+			model->plugin = this;
+			models.push_back(model);
+		}
+	};
+
+	namespace plugin
+	{
+		using rack::Model;
+		using rack::Plugin;
+	} // namespace plugin
+
+	namespace asset
+	{
+		inline std::string plugin(Plugin *plugin, std::string filename) { return filename; }
+		inline std::string system(std::string filename) { return filename; }
+	} // namespace asset
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Helpers
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	template <class TModule, class TModuleWidget>
+	Model *createModel(std::string slug)
+	{
+		struct TModel : Model
+		{
+			Module *createModule() override
+			{
+				TModule *m = new TModule;
+				m->model = this;
+				return m;
+			}
+
+			ModuleWidget *createModuleWidget(Module *m) override
+			{
+				TModuleWidget *mw = new TModuleWidget(dynamic_cast<TModule *>(m));
+				mw->model = this;
+				return mw;
+			}
+		};
+
+		TModel *o = new TModel;
+		o->slug = slug;
+		return o;
+	}
+
+	inline Widget *createPanel(std::string svgPath) { return new SvgPanel; }
+
+	template <class TWidget>
+	TWidget *createWidget(Vec pos)
+	{
+		TWidget *o = new TWidget;
+		o->box.pos = pos;
+		return o;
+	}
+
+	template <class TWidget>
+	TWidget *createWidgetCentered(Vec pos)
+	{
+		TWidget *o = createWidget<TWidget>(pos);
+		o->box.pos = o->box.pos.minus(o->box.size.div(2));
+		return o;
+	}
+
+	template <class TParamWidget>
+	TParamWidget *createParam(Vec pos, Module *module, int paramId)
+	{
+		TParamWidget *o = createWidget<TParamWidget>(pos);
+		o->module = module;
+		o->paramId = paramId;
+		return o;
+	}
+
+	template <class TParamWidget>
+	TParamWidget *createParamCentered(Vec pos, Module *module, int paramId) { return createParam<TParamWidget>(pos, module, paramId); }
+
+	template <class TPortWidget>
+	TPortWidget *createInput(Vec pos, Module *module, int inputId)
+	{
+		TPortWidget *o = createWidget<TPortWidget>(pos);
+		o->module = module;
+		o->portId = inputId;
+		return o;
+	}
+
+	template <class TPortWidget>
+	TPortWidget *createInputCentered(Vec pos, Module *module, int inputId) { return createInput<TPortWidget>(pos, module, inputId); }
+
+	template <class TPortWidget>
+	TPortWidget *createOutput(Vec pos, Module *module, int outputId)
+	{
+		TPortWidget *o = createWidget<TPortWidget>(pos);
+		o->module = module;
+		o->portId = outputId;
+		return o;
+	}
+
+	template <class TPortWidget>
+	TPortWidget *createOutputCentered(Vec pos, Module *module, int outputId) { return createOutput<TPortWidget>(pos, module, outputId); }
+
+	template <class TModuleLightWidget>
+	TModuleLightWidget *createLight(Vec pos, Module *module, int firstLightId)
+	{
+		TModuleLightWidget *o = createWidget<TModuleLightWidget>(pos);
+		o->module = module;
+		o->firstLightId = firstLightId;
+		return o;
+	}
+
+	template <class TModuleLightWidget>
+	TModuleLightWidget *createLightCentered(Vec pos, Module *module, int firstLightId) { return createLight<TModuleLightWidget>(pos, module, firstLightId); }
+
+	template <class TParamWidget>
+	TParamWidget *createLightParam(Vec pos, Module *module, int paramId, int firstLightId)
+	{
+		TParamWidget *o = createParam<TParamWidget>(pos, module, paramId);
+		o->getLight()->module = module;
+		o->getLight()->firstLightId = firstLightId;
+		return o;
+	}
+
+	template <class TParamWidget>
+	TParamWidget *createLightParamCentered(Vec pos, Module *module, int paramId, int firstLightId) { return createLightParam<TParamWidget>(pos, module, paramId, firstLightId); }
+
+	template <class TMenuItem = MenuItem>
+	TMenuItem *createMenuItem(std::string text, std::string rightText = "", std::function<void()> action = [] {}, bool disabled = false)
+	{
+		TMenuItem *item = new TMenuItem;
+		item->text = text;
+		item->rightText = rightText;
+		item->disabled = disabled;
+		return item;
+	}
+
+	template <class TMenuLabel = MenuLabel>
+	TMenuLabel *createMenuLabel(std::string text)
+	{
+		TMenuLabel *label = new TMenuLabel;
+		label->text = text;
+		return label;
+	}
+
+	template <class TMenuItem = MenuItem>
+	TMenuItem *createSubmenuItem(std::string text, std::string rightText, std::function<void(Menu *menu)> createMenu, bool disabled = false)
+	{
+		return createMenuItem<TMenuItem>(text, rightText, [] {}, disabled);
+	}
+
+	template <typename T>
+	MenuItem *createIndexPtrSubmenuItem(std::string text, std::vector<std::string> labels, T *ptr, bool disabled = false)
+	{
+		return createMenuItem(text, "", [] {}, disabled);
+	}
+
+	inline MenuItem *createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter, std::function<void(size_t val)> setter, bool disabled = false, bool alwaysConsume = false)
+	{
+		return createMenuItem(text, "", [] {}, disabled);
+	}
+
+	template <typename T>
+	MenuItem *createBoolPtrMenuItem(std::string text, std::string rightText, T *ptr)
+	{
+		return createMenuItem(text, rightText);
+	}
+
+} // namespace rack
+
+// Plugin entry point, as exported by plugin.cpp
+extern "C"
+{
+	void init(rack::Plugin *plugin);
+}
@@ -1,5 +1,7 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-oversampling.hpp"
+#include "sts-saturation.hpp"
 #include <math.h>
 
 struct Clipper : Module
@@ -10,6 +12,8 @@ struct Clipper : Module
 		LTM_ATTN_PARAM,
 		UPPER_THRESHOLD_PARAM,
 		LOWER__THRESHOLD_PARAM,
+		FOLDS_PARAM,
+		SYMMETRY_PARAM,
 		PARAMS_LEN
 	};
 	enum InputId
@@ -30,127 +34,408 @@ struct Clipper : Module
 	};
 
 	// Some class-wide parameters
-	int clipMethod = 0; // 0 = Clip, 1 = Fold
+	int clipMethod = 0; // 0 = Clip, 1 = Fold, 2 = Multi-fold, 3 = Tanh, 4 = Soft-knee, 5 = Diode, 6 = Sine-fold
 #define CLIPMETHOD_CLIP 0
 #define CLIPMETHOD_FOLD 1
+#define CLIPMETHOD_MULTIFOLD 2
+#define CLIPMETHOD_TANH 3
+#define CLIPMETHOD_SOFT_KNEE 4
+#define CLIPMETHOD_DIODE 5
+#define CLIPMETHOD_SINE_FOLD 6
 	int polarity = 0; // 0 = Unipolar, 1 = Bipolar
 #define POLARITY_UNIPOLAR 0
 #define POLARITY_BIPOLAR 1
+	int oversampling = 0; // 0 = Off, 1 = 2x, 2 = 4x, 3 = 8x, as the number of 2x stages
+	int antiAliasing = 0; // 0 = Off, 1 = ADAA 1st order, 2 = ADAA 2nd order
+#define ANTIALIASING_OFF 0
+#define ANTIALIASING_ADAA1 1
+#define ANTIALIASING_ADAA2 2
 
 	// local class variable declarations. For some reason, putting them as static/dynamic in the class Process() function does not work.
 	// For instance, the PITCH_PARAM knob would infuence other instances of the same module. Putting it here circumvents the problem
 	float UTM_attn_param, LTM_attn_param, UTM_param, LTM_param;
-	float UTM_in = 0.f, LTM_in = 0.f;	// Modulation input
-	float UTM_mod = 0.f, LTM_mod = 0.f; // Modulation result
-	float out_Volt;
-	int num_channels, idx;
+	simd::float_4 poly_UTM_mod = 0.f, poly_LTM_mod = 0.f; // Modulation result, for the 4 poly channels being processed
+	int folds = 4;			// Multi-fold: the number of folds each way before the output holds
+	float fold_slope = 1.f; // Multi-fold: the slope of the folds back down, against the input. 1 folds symmetrically
+#define MIN_WINDOW_WIDTH 1e-3f // Narrowest window to fold or saturate in, as the thresholds can meet
+	int num_channels, num_groups, idx;
+
+	// Oversampling filters, one set per 4 poly channels
+	STS_Oversampler oversampler[4];
+	simd::float_4 poly_up[STS_OVERSAMPLE_MAX_FACTOR]; // The samples of 4 poly channels at the oversampled rate
+	int i;
+
+	// A straight piece of the curve, for 4 lanes. The pieces are numbered upwards. Each is given at its start, the breakpoint
+	// with the piece below, except the lowest one, which has no start and is given at its end
+	struct STS_Clip_Piece
+	{
+		simd::float_4 index;
+		simd::float_4 start, value, slope; // Where it starts, the curve there and its slope
+		simd::float_4 F1, F2;			   // The first and second antiderivatives of the curve at the start
+	};
+
+	// Antiderivative anti-aliasing state, per 4 poly channels: the last two inputs and the pieces of the curve they are on,
+	// the antiderivatives at the last input, and the divided difference of the second antiderivative between the last two.
+	// ADAA delays the output by half a sample at 1st order, by a sample at 2nd order
+	simd::float_4 adaa_x1[4], adaa_x2[4], adaa_piece2[4], adaa_F1[4], adaa_F2[4], adaa_diff1[4];
+	STS_Clip_Piece adaa_piece1[4];
+	simd::float_4 adaa_UTM[4], adaa_LTM[4]; // The thresholds the last input was put on the curve with
+	int adaa_folds[4];
+	float adaa_fold_slope[4];
+	int adaa_active = -1;	 // The anti-aliasing the state was set up for
+	int adaa_method = -1;	 // The clip method the state was set up for
+	int active_groups = 0;	 // The groups of 4 poly channels processed at the last sample
+	bool adaa_ready[4] = {}; // Per 4 poly channels, is the state set up?
+#define ADAA_EPSILON 1e-3f // Inputs closer than this are too close to divide by their distance
 
 	Clipper()
 	{
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
 		configParam(UTM_ATTN_PARAM, 0.f, 1.f, 0.f, "Attenuation for Upper Threshold Modulation");
-		configParam(LTM_ATTN_PARAM, 0.f, 1.f, 0.f, "Attenuation for Upper Threshold Modulation");
+		configParam(LTM_ATTN_PARAM, 0.f, 1.f, 0.f, "Attenuation for Lower Threshold Modulation");
 		configParam(UPPER_THRESHOLD_PARAM, 0.f, 5.f, 5.f, "Volt");
 		configParam(LOWER__THRESHOLD_PARAM, -5.f, 0.f, -5.f, "Volt");
+		configParam(FOLDS_PARAM, 1.f, 16.f, 4.f, "Multi-fold Folds");
+		getParamQuantity(FOLDS_PARAM)->snapEnabled = true;
+		configParam(SYMMETRY_PARAM, -1.f, 1.f, 0.f, "Multi-fold Symmetry");
 		configInput(INPUT_INPUT, "Audio In");
 		configInput(UTM_IN_INPUT, "Upper Threshold Modulation");
 		configInput(LTM_IN_INPUT, "Lower Threshold Modulation");
 		configOutput(OUTPUT_OUTPUT, "Audio Out");
 	}
 
-	void process(const ProcessArgs &args) override
+	// Clip or fold 4 poly channels at once, each at its own thresholds. Without branches: clip is a min and a max,
+	// fold reflects off the upper threshold, then off the lower one, each selected by a mask. Multi-fold is read off its piece
+	simd::float_4 STS_My_Clip(simd::float_4 in)
 	{
-		// If no VC/In connected, bail out
-		if (!getInput(INPUT_INPUT).isConnected())
+		STS_Clip_Piece p;
+
+		if (clipMethod == CLIPMETHOD_CLIP)
+			return simd::clamp(in, poly_LTM_mod, poly_UTM_mod);
+		if (clipMethod >= CLIPMETHOD_TANH)
+			return STS_My_Saturate(in);
+		if (clipMethod == CLIPMETHOD_MULTIFOLD)
+		{
+			STS_My_Piece(in, &p);
+			return p.value + p.slope * (in - p.start);
+		}
+
+		in = simd::ifelse(in > poly_UTM_mod, 2.f * poly_UTM_mod - in, in);
+		return simd::ifelse(in < poly_LTM_mod, 2.f * poly_LTM_mod - in, in);
+	}
+
+	// Saturate 4 poly channels at once with a soft curve, centred in the window between the thresholds and reaching them at its limits
+	simd::float_4 STS_My_Saturate(simd::float_4 in)
+	{
+		simd::float_4 mid = 0.5f * (poly_UTM_mod + poly_LTM_mod), half = simd::fmax(0.5f * (poly_UTM_mod - poly_LTM_mod), 0.5f * MIN_WINDOW_WIDTH);
+
+		in = (in - mid) / half;
+		switch (clipMethod)
+		{
+		case CLIPMETHOD_TANH:
+			in = STS_Tanh(in);
+			break;
+		case CLIPMETHOD_SOFT_KNEE:
+			in = STS_Soft_Knee(in);
+			break;
+		case CLIPMETHOD_DIODE:
+			in = STS_Diode(in);
+			break;
+		default:
+			in = STS_Sine(in);
+			break;
+		}
+		return mid + half * in;
+	}
+
+	// The clip and fold curves are made of straight pieces. Gets the piece each lane of in is on. With h = in - start, on the piece the curve is
+	// value + slope * h, and its first and second antiderivatives are F1 + value * h + slope * h^2 / 2 and
+	// F2 + F1 * h + value * h^2 / 2 + slope * h^3 / 6, with F1 and F2 set to keep them continuous over the pieces
+	void STS_My_Piece(simd::float_4 in, STS_Clip_Piece *p)
+	{
+		simd::float_4 U = poly_UTM_mod, L = poly_LTM_mod, D = poly_UTM_mod - poly_LTM_mod, W, below, above, beyond;
+
+		if (clipMethod == CLIPMETHOD_MULTIFOLD)
+		{
+			STS_My_Multifold_Piece(in, p);
 			return;
+		}
 
-		// If no Output connected, bail out
-		if (!getOutput(OUTPUT_OUTPUT).isConnected())
+		below = in < L;
+		above = in > U;
+		if (clipMethod == CLIPMETHOD_CLIP)
+		{
+			// All pieces start on the curve in between, whose antiderivatives are in^2 / 2 and in^3 / 6
+			p->index = simd::ifelse(below, 0.f, simd::ifelse(above, 2.f, 1.f));
+			p->start = simd::ifelse(above, U, L);
+			p->value = p->start;
+			p->slope = simd::ifelse(below | above, 0.f, 1.f);
+			p->F1 = 0.5f * p->start * p->start;
+			p->F2 = p->start * p->start * p->start / 6.f;
 			return;
+		}
 
-		// Get all the values from the module UI
-		UTM_attn_param = getParam(UTM_ATTN_PARAM).getValue();
-		LTM_attn_param = getParam(LTM_ATTN_PARAM).getValue();
-		UTM_param = getParam(UPPER_THRESHOLD_PARAM).getValue();
-		LTM_param = getParam(LOWER__THRESHOLD_PARAM).getValue();
-		UTM_in = getInput(UTM_IN_INPUT).getVoltage();
-		LTM_in = getInput(LTM_IN_INPUT).getVoltage();
+		// Past W, the reflection off the upper threshold goes below the lower one and is reflected once more. W is D past U,
+		// so its antiderivatives are worked out along the piece down from U
+		W = U + D;
+		beyond = in > W;
+		p->index = simd::ifelse(below, 0.f, simd::ifelse(beyond, 3.f, simd::ifelse(above, 2.f, 1.f)));
+		p->start = simd::ifelse(beyond, W, simd::ifelse(above, U, L));
+		p->value = simd::ifelse(above & ~beyond, U, L);
+		p->slope = simd::ifelse(below | (above & ~beyond), -1.f, 1.f);
+		p->F1 = simd::ifelse(beyond, 0.5f * U * U + (U - 0.5f * D) * D, 0.5f * p->start * p->start);
+		p->F2 = simd::ifelse(beyond, U * U * U / 6.f + (0.5f * U * U + (0.5f * U - D / 6.f) * D) * D, p->start * p->start * p->start / 6.f);
+	}
+
+	// Multi-fold is a triangle wave over the window between the thresholds: up from L to U along the input, then back down to L
+	// at fold_slope times the input, again and again. With D = U - L, its period is P = D + D / fold_slope. Past the set number of folds
+	// each way, it holds. The piece is found with a floor, so any overshoot costs the same. Measured from L, the first antiderivative
+	// of the triangle wave less its mean, the middle of the window, is 0 at every breakpoint. Its second antiderivative goes down by
+	// D^3 / 12 over every rising piece and up by D^3 / (12 * fold_slope^2) over every falling one. The mean adds back in closed form
+	void STS_My_Multifold_Piece(simd::float_4 in, STS_Clip_Piece *p)
+	{
+		simd::float_4 U = poly_UTM_mod, L = poly_LTM_mod, D, P, mid, rise, cycle, u, u_min, u_max, m, falling, top, bottom, s, F2;
+		float last = folds + 1, whole = (folds + 1) / 2, odd = (folds + 1) % 2; // The fold where the curve holds, as whole periods and a half
+
+		D = simd::fmax(U - L, MIN_WINDOW_WIDTH);
+		P = D + D / fold_slope;
+		mid = 0.5f * (U + L);
+		rise = D * D * D / 12.f;
+		cycle = rise * (1.f / (fold_slope * fold_slope) - 1.f);
+
+		// Going up, the folds are at the tops of the triangle wave first. Going down, at the bottoms
+		u = in - L;
+		u_max = whole * P + odd * D;
+		u_min = -whole * P + (1.f - odd) * D;
+
+		m = simd::floor(simd::clamp(u, u_min, u_max) / P);
+		falling = simd::clamp(u, u_min, u_max) - m * P >= D;
+		p->index = 2.f * m + simd::ifelse(falling, 1.f, 0.f);
+		p->value = simd::ifelse(falling, U, L);
+		p->slope = simd::ifelse(falling, -fold_slope, 1.f);
+		s = m * P + simd::ifelse(falling, D, 0.f);
+		F2 = m * cycle - simd::ifelse(falling, rise, 0.f);
 
-		// Compute the Upper Treshold Modulation (UTM) as per the controls
-		// UTM must always be > 0, LTM must always be < 0, to avoid artifacts of self-oscillating
-		if (getInput(UTM_IN_INPUT).isConnected())
+		// Past the last folds it holds, starting at the top one and ending at the bottom one. Lanes rounded past them are held too
+		top = (u >= u_max) | (p->index > (float)folds);
+		bottom = (u < u_min) | (p->index < (float)-folds);
+		p->index = simd::ifelse(top, last, simd::ifelse(bottom, -last, p->index));
+		p->value = simd::ifelse(top, odd ? U : L, simd::ifelse(bottom, odd ? L : U, p->value));
+		p->slope = simd::ifelse(top | bottom, 0.f, p->slope);
+		s = simd::ifelse(top, u_max, simd::ifelse(bottom, u_min, s));
+		F2 = simd::ifelse(top, whole * cycle - odd * rise, simd::ifelse(bottom, -whole * cycle - (1.f - odd) * rise, F2));
+
+		p->start = L + s;
+		p->F1 = mid * s;
+		p->F2 = 0.5f * mid * s * s + F2;
+	}
+
+	// First antiderivative of the curve
+	simd::float_4 STS_My_F1(simd::float_4 in)
+	{
+		STS_Clip_Piece p;
+		simd::float_4 h;
+
+		STS_My_Piece(in, &p);
+		h = in - p.start;
+		return p.F1 + (p.value + 0.5f * p.slope * h) * h;
+	}
+
+	// Second antiderivative of the curve
+	simd::float_4 STS_My_F2(simd::float_4 in)
+	{
+		STS_Clip_Piece p;
+		simd::float_4 h;
+
+		STS_My_Piece(in, &p);
+		h = in - p.start;
+		return p.F2 + (p.F1 + (0.5f * p.value + p.slope * h / 6.f) * h) * h;
+	}
+
+	// Clears the anti-aliasing state of the 4 poly channels of a group, as if their input had been 0V for ever
+	void STS_My_ADAA_Reset(int group)
+	{
+		STS_My_Piece(0.f, &adaa_piece1[group]);
+		adaa_x1[group] = 0.f;
+		adaa_x2[group] = 0.f;
+		adaa_piece2[group] = adaa_piece1[group].index;
+		adaa_F1[group] = STS_My_F1(0.f);
+		adaa_F2[group] = STS_My_F2(0.f);
+		adaa_diff1[group] = adaa_F1[group];
+		adaa_UTM[group] = poly_UTM_mod;
+		adaa_LTM[group] = poly_LTM_mod;
+		adaa_folds[group] = folds;
+		adaa_fold_slope[group] = fold_slope;
+		adaa_ready[group] = true;
+	}
+
+	// Clip or fold 4 poly channels of a group with antiderivative anti-aliasing: the output is the mean of the curve between the
+	// last inputs, the divided difference of its first antiderivative for 1st order, the second divided difference of its second
+	// antiderivative for 2nd order. Subtracting antiderivatives of close inputs loses all precision in float, so they are not subtracted:
+	// - On the same piece the divided differences are worked out from the curve itself, which is exact
+	// - On neighbouring pieces they are expanded around the breakpoint between them, where only the small parts past it are divided
+	// - Further apart, the distance is large enough to divide by
+	// Inputs too close to divide by are read from the curve at their mean.
+	// The 2nd order also divides by the distance between this input and the one before the last. If that is too small,
+	// the output is read from the curve at the mean of the three inputs, which is exact on one piece and close on neighbouring ones.
+	// When the thresholds, folds or symmetry move, the last input is put on the curve as it is now. Otherwise its piece and
+	// antiderivatives belong to another curve, and the breakpoint between the pieces is no longer between the inputs
+	simd::float_4 STS_My_ADAA(simd::float_4 in, int group)
+	{
+		STS_Clip_Piece p, p1 = adaa_piece1[group];
+		simd::float_4 x1 = adaa_x1[group], x2 = adaa_x2[group];
+		simd::float_4 F1, F2, diff, diff2, apart, next, close, mean, out, upper, k, f_k, F1_k, h, h1;
+
+		if (simd::movemask((poly_UTM_mod != adaa_UTM[group]) | (poly_LTM_mod != adaa_LTM[group])) || folds != adaa_folds[group] || fold_slope != adaa_fold_slope[group])
 		{
-			UTM_mod = UTM_attn_param * UTM_in + UTM_param;
-			if (polarity == POLARITY_BIPOLAR)
-			{
-				if (UTM_mod < 0.f)
-					UTM_mod = 0.f;
-			}
-			else
-			{
-				if (UTM_mod < 5.f)
-					UTM_mod = 5.f;
-			}
+			STS_My_Piece(x1, &p1);
+			adaa_F1[group] = STS_My_F1(x1);
+			adaa_F2[group] = STS_My_F2(x1);
+			adaa_UTM[group] = poly_UTM_mod;
+			adaa_LTM[group] = poly_LTM_mod;
+			adaa_folds[group] = folds;
+			adaa_fold_slope[group] = fold_slope;
 		}
+
+		STS_My_Piece(in, &p);
+		h = in - p.start;
+		h1 = x1 - p.start;
+		F1 = p.F1 + (p.value + 0.5f * p.slope * h) * h;
+		F2 = p.F2 + (p.F1 + (0.5f * p.value + p.slope * h / 6.f) * h) * h;
+		diff = in - x1;
+		apart = p.index != p1.index;
+
+		if (antiAliasing == ANTIALIASING_ADAA1)
+			out = p.value + 0.5f * p.slope * (h + h1);
 		else
-		{
-			if (polarity == POLARITY_BIPOLAR)
-				UTM_mod = UTM_param;
-			else
-				UTM_mod = UTM_param + 5.f;
-		}
+			diff2 = p.F1 + 0.5f * p.value * (h + h1) + p.slope * (h * h + h * h1 + h1 * h1) / 6.f;
 
-		// Compute the Lower Treshold Modulation (UTM) as per the controls
-		if (getInput(LTM_IN_INPUT).isConnected())
+		if (simd::movemask(apart))
 		{
-			LTM_mod = LTM_attn_param * LTM_in + LTM_param;
-			if (polarity == POLARITY_BIPOLAR)
+			// The breakpoint k is the start of the upper piece. Around it, the curve and its first antiderivative are the same on both sides
+			upper = p.index > p1.index;
+			k = simd::ifelse(upper, p.start, p1.start);
+			f_k = simd::ifelse(upper, p.value, p1.value);
+			F1_k = simd::ifelse(upper, p.F1, p1.F1);
+			h = in - k;
+			h1 = x1 - k;
+			next = simd::fabs(p.index - p1.index) == 1.f;
+			close = simd::fabs(diff) < ADAA_EPSILON;
+			if (antiAliasing == ANTIALIASING_ADAA1)
 			{
-				if (LTM_mod > 0.f)
-					LTM_mod = 0.f;
+				out = simd::ifelse(apart, simd::ifelse(next, f_k + (p.slope * h * h - p1.slope * h1 * h1) / (2.f * diff), (F1 - adaa_F1[group]) / diff), out);
+				out = simd::ifelse(apart & close, STS_My_Clip(0.5f * (in + x1)), out);
 			}
 			else
 			{
-				if (LTM_mod > 5.f)
-					LTM_mod = 5.f;
+				diff2 = simd::ifelse(apart, simd::ifelse(next, F1_k + 0.5f * f_k * (h + h1) + (p.slope * h * h * h - p1.slope * h1 * h1 * h1) / (6.f * diff), (F2 - adaa_F2[group]) / diff), diff2);
+				diff2 = simd::ifelse(apart & close, STS_My_F1(0.5f * (in + x1)), diff2);
 			}
 		}
-		else
+
+		if (antiAliasing == ANTIALIASING_ADAA2)
 		{
-			if (polarity == POLARITY_BIPOLAR)
-				LTM_mod = LTM_param;
-			else
-				LTM_mod = LTM_param + 5.f;
+			out = 2.f * (diff2 - adaa_diff1[group]) / (in - x2);
+			adaa_diff1[group] = diff2;
+
+			// All three on the same piece: the mean of a straight line is the line at the mean
+			mean = (in + x1 + x2) / 3.f;
+			out = simd::ifelse(~apart & (p1.index == adaa_piece2[group]), p.value + p.slope * (mean - p.start), out);
+			close = simd::fabs(in - x2) < ADAA_EPSILON;
+			if (simd::movemask(close))
+				out = simd::ifelse(close, STS_My_Clip(mean), out);
 		}
 
+		adaa_x2[group] = x1;
+		adaa_x1[group] = in;
+		adaa_piece2[group] = p1.index;
+		adaa_piece1[group] = p;
+		adaa_F1[group] = F1;
+		adaa_F2[group] = F2;
+		return out;
+	}
+
+	// Clip or fold 4 poly channels of a group, with the anti-aliasing set in the menu. It only applies to the curves made of
+	// straight pieces. The soft curves have no corners and alias much less, oversampling takes care of the rest
+	simd::float_4 STS_My_Kernel(simd::float_4 in, int group)
+	{
+		if (antiAliasing == ANTIALIASING_OFF || clipMethod >= CLIPMETHOD_TANH)
+			return STS_My_Clip(in);
+		return STS_My_ADAA(in, group);
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		// If no VC/In connected, bail out
+		if (!getInput(INPUT_INPUT).isConnected())
+			return;
+
+		// If no Output connected, bail out
+		if (!getOutput(OUTPUT_OUTPUT).isConnected())
+			return;
+
+		// Get all the values from the module UI
+		UTM_attn_param = getParam(UTM_ATTN_PARAM).getValue();
+		LTM_attn_param = getParam(LTM_ATTN_PARAM).getValue();
+		UTM_param = getParam(UPPER_THRESHOLD_PARAM).getValue();
+		LTM_param = getParam(LOWER__THRESHOLD_PARAM).getValue();
+		folds = (int)getParam(FOLDS_PARAM).getValue();
+		fold_slope = powf(4.f, getParam(SYMMETRY_PARAM).getValue()); // From 4 times shallower to 4 times steeper than the input
+
 		// Is the V-In connected and polyphonic?
 		num_channels = getInput(INPUT_INPUT).getChannels();
 		// First, match the # of output channels to the number of input channels, to ensure all other channels are reset to 0 V
 		getOutput(OUTPUT_OUTPUT).setChannels(num_channels);
 
-		for (idx = 0; idx < num_channels; idx++)
+		// A new anti-aliasing or clip method sets the state of all groups up again, the oversampling filters only for a new clip
+		// method. Groups that drop out start from a clean state when the channel count grows again
+		if (antiAliasing != adaa_active || clipMethod != adaa_method)
 		{
-			// Compute the new output voltage
-			out_Volt = getInput(INPUT_INPUT).getVoltage(idx);
-			// output to the correct channel, multiplied by the output volume
-
-			// If clip, set output to the threshold, else subtract from the threshold
-			if (clipMethod == CLIPMETHOD_CLIP)
+			for (i = 0; i < 4; i++)
 			{
-				if (out_Volt > UTM_mod)
-					out_Volt = UTM_mod;
-				if (out_Volt < LTM_mod)
-					out_Volt = LTM_mod;
+				adaa_ready[i] = false;
+				if (clipMethod != adaa_method)
+					oversampler[i].Reset();
 			}
-			else
+			adaa_active = antiAliasing;
+			adaa_method = clipMethod;
+		}
+		num_groups = (num_channels + 3) / 4;
+		for (i = num_groups; i < active_groups; i++)
+		{
+			adaa_ready[i] = false;
+			oversampler[i].Reset();
+		}
+		active_groups = num_groups;
+
+		// 4 channels at a time, each with its own thresholds
+		for (idx = 0; idx < num_channels; idx += 4)
+		{
+			// Compute the Upper and Lower Treshold Modulation (UTM, LTM) as per the controls. Polyphonic CV sets them per channel
+			// UTM must always be > 0, LTM must always be < 0, to avoid artifacts of self-oscillating (> 5V and < 5V when unipolar)
+			poly_UTM_mod = (polarity == POLARITY_BIPOLAR ? UTM_param : UTM_param + 5.f);
+			if (getInput(UTM_IN_INPUT).isConnected())
+				poly_UTM_mod = simd::fmax(UTM_attn_param * getInput(UTM_IN_INPUT).getPolyVoltageSimd<simd::float_4>(idx) + UTM_param,
+										  polarity == POLARITY_BIPOLAR ? 0.f : 5.f);
+			poly_LTM_mod = (polarity == POLARITY_BIPOLAR ? LTM_param : LTM_param + 5.f);
+			if (getInput(LTM_IN_INPUT).isConnected())
+				poly_LTM_mod = simd::fmin(LTM_attn_param * getInput(LTM_IN_INPUT).getPolyVoltageSimd<simd::float_4>(idx) + LTM_param,
+										  polarity == POLARITY_BIPOLAR ? 0.f : 5.f);
+
+			if (antiAliasing != ANTIALIASING_OFF && !adaa_ready[idx / 4])
+				STS_My_ADAA_Reset(idx / 4);
+
+			// Oversampled: bring the channels up to the oversampled rate, clip or fold them there and filter them back down
+			if (oversampling > 0)
 			{
-				if (out_Volt > UTM_mod)
-					out_Volt = UTM_mod - (out_Volt - UTM_mod);
-				if (out_Volt < LTM_mod)
-					out_Volt = LTM_mod - (out_Volt - LTM_mod);
+				oversampler[idx / 4].Set_Stages(oversampling);
+				oversampler[idx / 4].Upsample(getInput(INPUT_INPUT).getVoltageSimd<simd::float_4>(idx), poly_up);
+				for (i = 0; i < (1 << oversampling); i++)
+					poly_up[i] = STS_My_Kernel(poly_up[i], idx / 4);
+				getOutput(OUTPUT_OUTPUT).setVoltageSimd(oversampler[idx / 4].Downsample(poly_up), idx);
 			}
-
-			getOutput(OUTPUT_OUTPUT).setVoltage(out_Volt, idx);
+			else
+				getOutput(OUTPUT_OUTPUT).setVoltageSimd(STS_My_Kernel(getInput(INPUT_INPUT).getVoltageSimd<simd::float_4>(idx), idx / 4), idx);
 		}
 		// Done, so exit
 		return;
@@ -163,6 +448,8 @@ struct Clipper : Module
 
 		json_object_set_new(rootJ, "Clip Method", json_integer(clipMethod));
 		json_object_set_new(rootJ, "Polarity", json_integer(polarity));
+		json_object_set_new(rootJ, "Oversampling", json_integer(oversampling));
+		json_object_set_new(rootJ, "Anti-aliasing", json_integer(antiAliasing));
 
 		return rootJ;
 	}
@@ -171,11 +458,17 @@ struct Clipper : Module
 	{
 		json_t *clipMethodJ = json_object_get(rootJ, "Clip Method");
 		json_t *polarityJ = json_object_get(rootJ, "Polarity");
+		json_t *oversamplingJ = json_object_get(rootJ, "Oversampling");
+		json_t *antiAliasingJ = json_object_get(rootJ, "Anti-aliasing");
 
 		if (clipMethodJ)
 			clipMethod = json_integer_value(clipMethodJ);
 		if (polarityJ)
 			polarity = json_integer_value(polarityJ);
+		if (oversamplingJ)
+			oversampling = clamp((int)json_integer_value(oversamplingJ), 0, STS_OVERSAMPLE_MAX_STAGES);
+		if (antiAliasingJ)
+			antiAliasing = clamp((int)json_integer_value(antiAliasingJ), ANTIALIASING_OFF, ANTIALIASING_ADAA2);
 	}
 };
 
@@ -195,6 +488,8 @@ struct ClipperWidget : ModuleWidget
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(18.5, 52.5)), module, Clipper::LTM_ATTN_PARAM));
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(12.7, 76.5)), module, Clipper::UPPER_THRESHOLD_PARAM));
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(12.7, 97.2)), module, Clipper::LOWER__THRESHOLD_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(4.4, 76.5)), module, Clipper::FOLDS_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(21.0, 76.5)), module, Clipper::SYMMETRY_PARAM));
 
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.0, 14.0)), module, Clipper::INPUT_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 32.5)), module, Clipper::UTM_IN_INPUT));
@@ -208,8 +503,10 @@ struct ClipperWidget : ModuleWidget
 
 		menu->addChild(new MenuSeparator);
 
-		menu->addChild(createIndexPtrSubmenuItem("Clip Method", {"Clip", "Fold"}, &module->clipMethod));
+		menu->addChild(createIndexPtrSubmenuItem("Clip Method", {"Clip", "Fold", "Multi-fold", "Tanh", "Soft-knee", "Diode", "Sine-fold"}, &module->clipMethod));
 		menu->addChild(createIndexPtrSubmenuItem("Polarity", {"Unipolar (0..10V)", "Bipolar (-5V..5V)"}, &module->polarity));
+		menu->addChild(createIndexPtrSubmenuItem("Oversampling", {"Off", "2x", "4x", "8x"}, &module->oversampling));
+		menu->addChild(createIndexPtrSubmenuItem("Anti-aliasing", {"Off", "ADAA 1st order", "ADAA 2nd order"}, &module->antiAliasing));
 	}
 };
 
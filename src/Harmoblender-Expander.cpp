@@ -0,0 +1,133 @@
+#include "plugin.hpp"
+#include "sts-base.hpp"
+#include "sts-wavetables.hpp"
+#include "Harmoblender.hpp"
+#include <math.h>
+
+struct Harmoblender_Expander : Module
+{
+	enum ParamId
+	{
+		ENUMS(HRM_LVL_PARAMS, STS_HRM_BANK_PARTIALS),
+		ENUMS(HRM_PHASE_PARAMS, STS_HRM_BANK_PARTIALS),
+		ENUMS(HRM_MULT_PARAMS, STS_HRM_BANK_PARTIALS),
+		PARAMS_LEN
+	};
+	enum InputId
+	{
+		ENUMS(HRM_LVL_INPUTS, STS_HRM_BANK_PARTIALS),
+		ENUMS(HRM_PHASE_INPUTS, STS_HRM_BANK_PARTIALS),
+		INPUTS_LEN
+	};
+	enum OutputId
+	{
+		OUTPUTS_LEN
+	};
+	enum LightId
+	{
+		LIGHTS_LEN
+	};
+
+	Harmoblender_Expander()
+	{
+		int i = 0;			// index for harmonics loops
+		std::string fmt;	// string to format text
+		char name[64] = {}; // string to format text
+
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+		// Harmonic Blenders, numbered on from the 16 of the Harmoblender
+		for (i = 0; i < STS_HRM_BANK_PARTIALS; i++)
+		{
+			// Harmonic Blender Params
+			(void)sprintf(name, "Harmonic +%d Level", i + 1);
+			fmt = name;
+			configParam(HRM_LVL_PARAMS + i, -1.f, 1.f, 0.f, fmt);
+
+			(void)sprintf(name, "Harmonic +%d Phase Shift", i + 1);
+			fmt = name;
+			configParam(HRM_PHASE_PARAMS + i, 0.f, 0.999f, 0.f, fmt);
+
+			(void)sprintf(name, "Harmonic +%d Multiplication", i + 1);
+			fmt = name;
+			configParam(HRM_MULT_PARAMS + i, 0.f, (float)STS_HRM_MAX_MULT, float(STS_HRM_BANK_PARTIALS + i + 1), fmt);
+			getParamQuantity(HRM_MULT_PARAMS + i)->snapEnabled = true;
+
+			(void)sprintf(name, "Harmonic +%d Level CV (0..10V)", i + 1);
+			fmt = name;
+			configInput(HRM_LVL_INPUTS + i, fmt);
+
+			(void)sprintf(name, "Harmonic +%d Phase Shift CV (0..10V)", i + 1);
+			fmt = name;
+			configInput(HRM_PHASE_INPUTS + i, fmt);
+		}
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		int i = 0;					  // used to loop through harmonics
+		int bank = 0;				  // Which bank of the Harmoblender this expander fills
+		Module *master;				  // The Harmoblender
+		STS_Hrm_Bank *partials;		  // Where this expander writes its partials
+
+		// Find the Harmoblender on the left, past the expanders in between. Each of those fills a bank before this one
+		for (master = leftExpander.module; master && master->model == modelHarmoblender_Expander; master = master->leftExpander.module)
+			bank++;
+		if (!master || master->model != modelHarmoblender || bank >= STS_HRM_MAX_BANKS)
+			return;
+
+		partials = &((STS_Hrm_Expander_Message *)master->rightExpander.producerMessage)->bank[bank];
+		partials->cv_Connected = false;
+
+		// Compute the partials exactly like the Harmoblender does for its own
+		for (i = 0; i < STS_HRM_BANK_PARTIALS; i++)
+		{
+			if (getInput(HRM_PHASE_INPUTS + i).isConnected() || getInput(HRM_LVL_INPUTS + i).isConnected())
+				partials->cv_Connected = true;
+			if (getInput(HRM_PHASE_INPUTS + i).isConnected())
+				partials->phase_shift[i] = STS_Fixed_Phase(abs(0.1f * getInput(HRM_PHASE_INPUTS + i).getVoltage()) + getParam(HRM_PHASE_PARAMS + i).getValue());
+			else
+				partials->phase_shift[i] = STS_Fixed_Phase(getParam(HRM_PHASE_PARAMS + i).getValue());
+			if (getInput(HRM_LVL_INPUTS + i).isConnected())
+				partials->level[i] = 0.1f * getInput(HRM_LVL_INPUTS + i).getVoltage();
+			else
+				partials->level[i] = getParam(HRM_LVL_PARAMS + i).getValue();
+			partials->multiplication[i] = (uint32_t)getParam(HRM_MULT_PARAMS + i).getValue();
+		}
+
+		master->rightExpander.requestMessageFlip();
+	}
+};
+
+struct Harmoblender_ExpanderWidget : ModuleWidget
+{
+	Harmoblender_ExpanderWidget(Harmoblender_Expander *module)
+	{
+		// Same grid as the Harmoblender: 4 x 4 panels of a level, phase and multiplication knob with the level and phase CV below
+		static const float panel_x[4] = {8.0f, 41.556f, 75.112f, 108.668f};
+		static const float panel_y[4] = {15.5f, 39.171f, 62.671f, 86.341f};
+		float x, y;
+		int i;
+
+		setModule(module);
+		setPanel(createPanel(asset::plugin(pluginInstance, "res/Harmoblender-Expander.svg")));
+
+		addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+		for (i = 0; i < STS_HRM_BANK_PARTIALS; i++)
+		{
+			x = panel_x[i % 4];
+			y = panel_y[i / 4];
+			addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(x, y)), module, Harmoblender_Expander::HRM_LVL_PARAMS + i));
+			addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(x + 10.f, y)), module, Harmoblender_Expander::HRM_PHASE_PARAMS + i));
+			addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(x + 20.f, y)), module, Harmoblender_Expander::HRM_MULT_PARAMS + i));
+			addInput(createInputCentered<PJ301MPort>(mm2px(Vec(x, y + 10.5f)), module, Harmoblender_Expander::HRM_LVL_INPUTS + i));
+			addInput(createInputCentered<PJ301MPort>(mm2px(Vec(x + 10.f, y + 10.5f)), module, Harmoblender_Expander::HRM_PHASE_INPUTS + i));
+		}
+	}
+};
+
+Model *modelHarmoblender_Expander = createModel<Harmoblender_Expander, Harmoblender_ExpanderWidget>("Harmoblender-Expander");
@@ -1,7 +1,418 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-wavetables.hpp"
+#include "Harmoblender.hpp"
 #include <math.h>
 
+#define STS_ANALYSIS_SIZE 4096		   // FFT length up to 48 kHz, it doubles with the sample rate so the bins stay about 12 Hz wide
+#define STS_ANALYSIS_MAX_SIZE 16384	   // FFT length at 192 kHz
+#define STS_ANALYSIS_HOPS 4			   // Analyses per FFT length, so the windows overlap by 3/4
+#define STS_ANALYSIS_MIN_FREQ 25.f	   // Range of the fundamental
+#define STS_ANALYSIS_MAX_FREQ 2000.f
+#define STS_ANALYSIS_SILENCE 0.001f	   // Below this amplitude in volts, the input is silent and all levels go to 0
+#define STS_ANALYSIS_SMOOTHING 0.02f // Time constant in seconds of the levels and phases following the analysis
+#define STS_NUM_SNAPSHOTS 16		   // Slots in the snapshot bank
+
+// The partials found in the audio input at the multiplications of the partials, relative to its fundamental
+struct STS_Hrm_Snapshot
+{
+	float level[STS_MAX_PARTIALS];
+	uint32_t phase_shift[STS_MAX_PARTIALS]; // In fixed point cycles, relative to the phase of the fundamental
+};
+
+// Spectral analysis of the resynthesis input on the plugin-wide worker thread. The audio thread only collects the input and,
+// every hop, copies the last FFT length of it into the frame. The worker thread takes the FFT of the frame, finds the fundamental
+// and reads the level and phase at each multiplication. The snapshots are handed back like the tables of the baker: the audio thread
+// swaps in the latest one through the ready flag and never waits
+struct STS_Hrm_Analyzer : STS_Worker_Job
+{
+	// Only touched by the audio thread
+	float ring[STS_ANALYSIS_MAX_SIZE] = {};
+	int ring_pos = 0;
+	int hop_count = 0;
+	int active = 0; // Snapshot in use by the audio thread
+
+	// Written by the audio thread while sending is false, read by the worker thread while it is true
+	std::atomic<bool> sending;
+	float frame[STS_ANALYSIS_MAX_SIZE] = {};
+	int frame_size = 0;
+	float frame_sample_rate = 0.f;
+	uint32_t frame_mult[STS_MAX_PARTIALS] = {};
+	int frame_num = 0;
+
+	// Only touched by the worker thread. pffft wants its buffers 16 byte aligned
+	std::unique_ptr<dsp::RealFFT> fft;
+	int fft_size = 0;
+	alignas(16) float windowed[STS_ANALYSIS_MAX_SIZE];
+	alignas(16) float spectrum[STS_ANALYSIS_MAX_SIZE];
+	float magnitude[STS_ANALYSIS_MAX_SIZE / 2];
+	int build = 0; // Snapshot last written by the worker thread
+
+	std::atomic<bool> ready;
+	STS_Hrm_Snapshot snapshots[2] = {};
+
+	STS_Hrm_Analyzer() : sending(false), ready(false) {}
+	~STS_Hrm_Analyzer() { Cancel(); }
+
+	// From the audio thread: collects one input sample, and sends a frame every hop unless the worker thread is still busy with the last one
+	void Push(float in, float sample_rate, const uint32_t *mult, int num)
+	{
+		int size = STS_ANALYSIS_SIZE, i;
+
+		ring[ring_pos] = in;
+		ring_pos = (ring_pos + 1) & (STS_ANALYSIS_MAX_SIZE - 1);
+
+		while (size < STS_ANALYSIS_MAX_SIZE && (float)size * 48000.f < STS_ANALYSIS_SIZE * sample_rate)
+			size *= 2;
+		if (++hop_count < size / STS_ANALYSIS_HOPS || sending.load(std::memory_order_acquire))
+			return;
+		hop_count = 0;
+
+		for (i = 0; i < size; i++)
+			frame[i] = ring[(ring_pos - size + i) & (STS_ANALYSIS_MAX_SIZE - 1)];
+		frame_size = size;
+		frame_sample_rate = sample_rate;
+		for (i = 0; i < num; i++)
+			frame_mult[i] = mult[i];
+		frame_num = num;
+
+		sending.store(true, std::memory_order_release);
+		if (!Try_Request())
+			sending.store(false, std::memory_order_release);
+	}
+
+	// From the audio thread: the latest snapshot
+	const STS_Hrm_Snapshot *Get()
+	{
+		if (ready.load(std::memory_order_acquire) && ready.exchange(false))
+			active ^= 1;
+		return &snapshots[active];
+	}
+
+	// Offset from the middle bin of the top of the parabola through 3 log magnitudes. The middle bin need not be the highest, and the
+	// parabola can then be nearly flat with its top far away, so the offset is held to the half bin either side
+	static float Vertex(float a, float b, float c)
+	{
+		return ((a - 2.f * b + c) < 0.f ? clamp(0.5f * (a - c) / (a - 2.f * b + c), -0.5f, 0.5f) : 0.f);
+	}
+
+	// Magnitude and phase of a peak between bins, by fitting a parabola through the log magnitudes around bin k
+	void Peak(float bin, float *amplitude, float *phase)
+	{
+		int k = (int)(bin + 0.5f);
+		float a, b, c, p;
+
+		// The strongest of the nearest bins, for a slightly mistuned partial
+		if (magnitude[k - 1] > magnitude[k] && magnitude[k - 1] > magnitude[k + 1])
+			k--;
+		else if (magnitude[k + 1] > magnitude[k])
+			k++;
+		if (k < 1 || k >= fft_size / 2 - 1)
+		{
+			*amplitude = 0.f;
+			*phase = 0.f;
+			return;
+		}
+
+		a = std::log(magnitude[k - 1] + 1e-20f);
+		b = std::log(magnitude[k] + 1e-20f);
+		c = std::log(magnitude[k + 1] + 1e-20f);
+		p = Vertex(a, b, c);
+
+		// A sine of amplitude A peaks at A * N / 4 with the Hann window
+		*amplitude = std::exp(b - 0.25f * (a - c) * p) * (4.f / fft_size);
+		// The window is centred on sample 0, so the phase is that of the centre of the frame. Sines lag cosines by a quarter cycle
+		*phase = std::atan2(spectrum[2 * k + 1], spectrum[2 * k]) * (1.f / M_2PI) + 0.25f;
+	}
+
+	void Build() override
+	{
+		STS_Hrm_Snapshot *snapshot;
+		bool expected = true;
+		float bin_freq, score, best_Score = 0.f, peak = 0.f, amplitude, phase, fundamental_Phase, a, b, c;
+		int i, k, k_min, k_max, best_K = 0, n;
+
+		if (!sending.load(std::memory_order_acquire))
+			return;
+
+		n = frame_size;
+		if (n != fft_size)
+		{
+			fft.reset(new dsp::RealFFT(n));
+			fft_size = n;
+		}
+
+		// Hann window, rotated by half a frame so its centre is at sample 0: a zero-phase window
+		for (i = 0; i < n; i++)
+		{
+			k = (i + n / 2) & (n - 1);
+			windowed[i] = frame[k] * (0.5f - 0.5f * std::cos(M_2PI * k / n));
+		}
+		fft->rfft(windowed, spectrum);
+
+		magnitude[0] = 0.f;
+		for (k = 1; k < n / 2; k++)
+		{
+			magnitude[k] = std::sqrt(spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1]);
+			if (magnitude[k] > peak)
+				peak = magnitude[k];
+		}
+
+		// If the audio thread has not picked up the last snapshot yet, write it again, else write the other one starting from the last
+		if (!ready.compare_exchange_strong(expected, false))
+		{
+			snapshots[build ^ 1] = snapshots[build];
+			build ^= 1;
+		}
+		snapshot = &snapshots[build];
+
+		// The fundamental: the bin with the strongest product of its first 3 harmonics, so a missing or weak fundamental is still found
+		bin_freq = frame_sample_rate / n;
+		k_min = std::max(2, (int)(STS_ANALYSIS_MIN_FREQ / bin_freq));
+		k_max = std::min((int)(STS_ANALYSIS_MAX_FREQ / bin_freq), (n / 2 - 2) / 3);
+		for (k = k_min; k <= k_max; k++)
+		{
+			score = magnitude[k] * std::max(magnitude[2 * k - 1], std::max(magnitude[2 * k], magnitude[2 * k + 1])) *
+					std::max(magnitude[3 * k - 1], std::max(magnitude[3 * k], magnitude[3 * k + 1]));
+			if (score > best_Score)
+			{
+				best_Score = score;
+				best_K = k;
+			}
+		}
+
+		if (best_K == 0 || peak * (4.f / n) < STS_ANALYSIS_SILENCE)
+		{
+			// Silence: fade out, but keep the phases so the partials do not swirl when the input returns
+			for (i = 0; i < STS_MAX_PARTIALS; i++)
+				snapshot->level[i] = 0.f;
+		}
+		else
+		{
+			// Between bins, where the parabola through the log magnitudes peaks
+			a = std::log(magnitude[best_K - 1] + 1e-20f);
+			b = std::log(magnitude[best_K] + 1e-20f);
+			c = std::log(magnitude[best_K + 1] + 1e-20f);
+			bin_freq = best_K + Vertex(a, b, c);
+
+			Peak(bin_freq, &amplitude, &fundamental_Phase);
+			for (i = 0; i < STS_MAX_PARTIALS; i++)
+			{
+				if (i >= frame_num || frame_mult[i] == 0 || frame_mult[i] * bin_freq >= n / 2 - 2)
+				{
+					snapshot->level[i] = 0.f;
+					continue;
+				}
+				Peak(frame_mult[i] * bin_freq, &amplitude, &phase);
+				// The Harmoblender plays 5 * level * sin(multiplication * fundamental + phase shift)
+				snapshot->level[i] = 0.2f * amplitude;
+				snapshot->phase_shift[i] = STS_Fixed_Phase(phase - frame_mult[i] * fundamental_Phase);
+			}
+		}
+
+		sending.store(false, std::memory_order_release);
+		ready.store(true, std::memory_order_release);
+	}
+};
+
+// The analyzer takes some 300 KB of buffers, so it only exists while the resynthesis input is patched. The worker thread allocates it
+// when the input gets patched and frees it once the audio thread hands it back, after the input is unpatched. The audio thread
+// asks for either only when the input changes, and never waits for the worker thread
+struct STS_Hrm_Analyzer_Slot : STS_Worker_Job
+{
+	// Only touched by the audio thread
+	STS_Hrm_Analyzer *active = NULL; // Analyzer in use
+	bool patched = false;			 // Input patched at the last sample
+	bool pending = false;			 // The worker thread has not taken the last change yet
+
+	// Handed over between the threads
+	std::atomic<bool> wanted;					// Input patched, as last told to the worker thread
+	std::atomic<STS_Hrm_Analyzer *> fresh;	// Allocated by the worker thread, not picked up yet
+	std::atomic<STS_Hrm_Analyzer *> retired; // Handed back by the audio thread, not freed yet
+
+	// Only touched by the worker thread
+	int live = 0; // Analyzers allocated and not freed yet, wherever they are
+
+	STS_Hrm_Analyzer_Slot() : wanted(false), fresh(NULL), retired(NULL) {}
+	~STS_Hrm_Analyzer_Slot()
+	{
+		Cancel();
+		delete active;
+		delete fresh.load();
+		delete retired.load();
+	}
+
+	// From the audio thread: the analyzer, or NULL while the input is not patched or the analyzer is not allocated yet
+	STS_Hrm_Analyzer *Get(bool is_patched)
+	{
+		if (is_patched != patched)
+		{
+			patched = is_patched;
+			wanted.store(patched, std::memory_order_release);
+			if (!patched && active)
+			{
+				retired.store(active, std::memory_order_release);
+				active = NULL;
+			}
+			pending = true;
+		}
+		if (pending)
+			pending = !Try_Request();
+		if (patched && !active)
+			active = fresh.exchange(NULL, std::memory_order_acquire);
+		return active;
+	}
+
+	void Build() override
+	{
+		STS_Hrm_Analyzer *analyzer;
+
+		if ((analyzer = retired.exchange(NULL, std::memory_order_acquire)) != NULL)
+		{
+			delete analyzer;
+			live--;
+		}
+		if (!wanted.load(std::memory_order_acquire))
+		{
+			if ((analyzer = fresh.exchange(NULL, std::memory_order_acquire)) != NULL)
+			{
+				delete analyzer;
+				live--;
+			}
+		}
+		else if (live == 0)
+		{
+			fresh.store(new STS_Hrm_Analyzer(), std::memory_order_release);
+			live++;
+		}
+	}
+};
+
+// A timbre in the snapshot bank: the partials of the panel and the expanders when it was stored
+struct STS_Hrm_Timbre
+{
+	bool stored = false;
+	int num = 0;
+	STS_Partial partials[STS_MAX_PARTIALS];
+};
+
+// Bakes the tables of each stored snapshot on the worker thread, so morphing is a crossfade between table reads
+// Like the tables of the VCOs, each snapshot is a mipmap: level L keeps the partials up to STS_HRM_MAX_MULT >> L, so each next level
+// is for a fundamental an octave higher. A level without partials above the next one is the same table, so it is only baked once
+// The tables of all snapshots are handed over at once, like the tables of the baker. The snapshots are only ever changed
+// from the UI thread, so handing them over may wait for the lock
+#define STS_MORPH_LEVELS 6 // Down to the fundamental alone
+
+typedef const STS_Wavetable *STS_Hrm_Morph_Levels[STS_MORPH_LEVELS];
+
+struct STS_Hrm_Morph_Baker : STS_Worker_Job
+{
+	std::mutex requested_mutex;
+	STS_Hrm_Timbre requested[STS_NUM_SNAPSHOTS];
+
+	std::atomic<bool> ready;
+	int active = 0; // Tables in use by the audio thread
+	int build = 0;	// Tables last written by the worker thread
+	std::unique_ptr<STS_Wavetable[]> tables[2];		  // The distinct tables of all levels, allocated as needed
+	int capacity[2] = {};							  // Tables allocated
+	STS_Hrm_Morph_Levels levels[2][STS_NUM_SNAPSHOTS]; // The levels of the stored snapshots in slot order
+	int count[2] = {};
+
+	STS_Hrm_Morph_Baker() : ready(false) {}
+	~STS_Hrm_Morph_Baker() { Cancel(); }
+
+	// Not from the audio thread: bake these snapshots
+	void Set(const STS_Hrm_Timbre *snapshots)
+	{
+		{
+			std::lock_guard<std::mutex> lock(requested_mutex);
+			for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+				requested[i] = snapshots[i];
+		}
+		Request();
+	}
+
+	// From the audio thread: the levels of the stored snapshots, returns how many there are
+	int Get(const STS_Hrm_Morph_Levels **morph_levels)
+	{
+		if (ready.load(std::memory_order_acquire) && ready.exchange(false))
+			active ^= 1;
+		*morph_levels = levels[active];
+		return count[active];
+	}
+
+	// Whether level differs from the level before it: a partial is heard above the limit of level and up to that of the one before
+	static bool New_Level(const STS_Hrm_Timbre &snapshot, int level)
+	{
+		for (int i = 0; i < snapshot.num; i++)
+		{
+			if (snapshot.partials[i].level != 0.f && snapshot.partials[i].multiplication > (uint32_t)(STS_HRM_MAX_MULT >> level))
+				return true;
+		}
+		return false;
+	}
+
+	void Build() override
+	{
+		std::unique_ptr<STS_Hrm_Timbre[]> wanted(new STS_Hrm_Timbre[STS_NUM_SNAPSHOTS]);
+		STS_Partial partials[STS_MAX_PARTIALS];
+		bool expected = true;
+		int i, j, l, n = 0, needed = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(requested_mutex);
+			for (i = 0; i < STS_NUM_SNAPSHOTS; i++)
+				wanted[i] = requested[i];
+		}
+
+		// If the audio thread has not picked up the last tables yet, build into them again, else into the other ones
+		if (!ready.compare_exchange_strong(expected, false))
+			build ^= 1;
+
+		for (i = 0; i < STS_NUM_SNAPSHOTS; i++)
+		{
+			if (!wanted[i].stored)
+				continue;
+			needed++;
+			for (l = 1; l < STS_MORPH_LEVELS; l++)
+				needed += New_Level(wanted[i], l);
+		}
+		if (needed > capacity[build])
+		{
+			tables[build].reset(new STS_Wavetable[needed]);
+			capacity[build] = needed;
+		}
+
+		// Each new level bakes the partials up to its limit, the others silent
+		needed = 0;
+		for (i = 0; i < STS_NUM_SNAPSHOTS; i++)
+		{
+			if (!wanted[i].stored)
+				continue;
+			for (l = 0; l < STS_MORPH_LEVELS; l++)
+			{
+				if (l > 0 && !New_Level(wanted[i], l))
+				{
+					levels[build][n][l] = levels[build][n][l - 1];
+					continue;
+				}
+				for (j = 0; j < wanted[i].num; j++)
+				{
+					partials[j] = wanted[i].partials[j];
+					if (partials[j].multiplication > (uint32_t)(STS_HRM_MAX_MULT >> l))
+						partials[j].level = 0.f;
+				}
+				STS_Bake_Partials(&tables[build][needed], partials, wanted[i].num);
+				levels[build][n][l] = &tables[build][needed++];
+			}
+			n++;
+		}
+		count[build] = n;
+
+		ready.store(true, std::memory_order_release);
+	}
+};
+
 struct Harmoblender : Module
 {
 	enum ParamId
@@ -19,6 +430,8 @@ struct Harmoblender : Module
 		ENUMS(HRM_PHASE_INPUTS, 16),
 		PITCH_IN_PARAM,
 		V_OCT_IN_INPUT,
+		RESYNTH_INPUT,
+		MORPH_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId
@@ -36,45 +449,255 @@ struct Harmoblender : Module
 	const float PHASE_MOD_MULTIPLIER = 0.1f;
 	const float VOLUME_MOD_MULTIPLIER = 0.1f;
 
-#define STS_NUM_WAVE_SAMPLES 1000
+#define STS_SYNTHESIS_LIVE 0  // Add up all partials at every sample
+#define STS_SYNTHESIS_BAKED 1 // Play a table with all partials baked in, as long as no level or phase CV is patched
+#define STS_ROTATOR_RESYNC 64 // Samples between setting the rotators from the exact phase
+#define STS_QUARTER_CYCLE (1 << 30) // In fixed point, from a sine to a cosine
+#define STS_NYQUIST_FADE 0.05f		// Partials fade out over this band below Nyquist, in cycles per sample
+
+	int interpolation = STS_INTERPOLATE_LINEAR;
+	int synthesis = STS_SYNTHESIS_LIVE;
+
+	// The sine wave, shared read-only with all other instances. This can arguebly be regarded as a wavetable
+	std::shared_ptr<const STS_Wavetable> sine_wave_lookup_table;
 
-	// An array of values to represent the sine wave, as values in the range [-1.0, 1.0]. This can arguebly be regarded as a wavetable
-	float sine_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
+	// For baked synthesis: the partials are baked into a table on the worker thread whenever the knobs change
+	STS_Additive_Baker hrm_Baker;
+	STS_Partial hrm_Partials[STS_MAX_PARTIALS];
 
-	// local class variable
-	float hrm_Lvl[16] = {};			   // To store the level for this harmonic
-	float hrm_Phase_Shift[16] = {};	   // To store the phase shift for this harmonic
-	float hrm_Multiplication[16] = {}; // To sore the multiplication factor for this harmonic
+	// For resynthesis: the levels and phase shifts follow the analysis of the audio input, smoothed
+	STS_Hrm_Analyzer_Slot hrm_Analyzer;
+	float rsy_Lvl[STS_MAX_PARTIALS] = {};
+	uint32_t rsy_Phase_Shift[STS_MAX_PARTIALS] = {};
+
+	// The snapshot bank, only touched by the UI thread. With the morph CV patched, the stored snapshots replace the partials
+	STS_Hrm_Timbre hrm_Snapshots[STS_NUM_SNAPSHOTS];
+	STS_Hrm_Morph_Baker hrm_Morph;
+
+	// The partials of the expanders on the right arrive in this double buffer, the engine flips it after each sample
+	STS_Hrm_Expander_Message hrm_Messages[2] = {};
+	int hrm_Num_Banks = 0;						// Number of expanders found at the last sample
+	int hrm_Num_Partials = STS_HRM_BANK_PARTIALS; // Partials on this panel and all expanders
+
+	// local class variable, the partials of the expanders follow those of this panel
+	float hrm_Lvl[STS_MAX_PARTIALS] = {};				 // To store the level for this harmonic
+	uint32_t hrm_Phase_Shift[STS_MAX_PARTIALS] = {};	 // To store the phase shift for this harmonic, in fixed point cycles
+	uint32_t hrm_Multiplication[STS_MAX_PARTIALS] = {}; // To sore the multiplication factor for this harmonic, a whole number so the fixed point phase multiplies exactly
 	float lvl_Multiplier = 0.f;		   // Global Level param, used to reduce the output level
 
 	float freq = 0.f, pitch = 0.f, phase_shift = 0.f;
 	int num_channels, idx;
 
+	// The poly channels of a baked table are computed 4 at a time
+	simd::float_4 poly_pitch, poly_freq;
+	simd::int32_4 poly_phase;
+
 	// Array of 16 phases to accomodate for polyphony
-	float phase[16] = {};
+	uint32_t phase[16] = {};
+	uint32_t channel_inc[16] = {}; // Phase increment of each channel at this sample
+
+	// For live synthesis, each partial of each channel is a rotator: the cosine & sine of its phase, advanced at every sample
+	// by a complex multiplication with the cosine & sine of its phase increment. Rounding makes them drift, so every STS_ROTATOR_RESYNC
+	// samples they are set again from the exact fixed point phase, which also renormalises them
+	float rot_Cos[16][STS_MAX_PARTIALS] = {}, rot_Sin[16][STS_MAX_PARTIALS] = {};
+	float rot_Step_Cos[16][STS_MAX_PARTIALS] = {}, rot_Step_Sin[16][STS_MAX_PARTIALS] = {};
+	uint32_t rot_Inc[16] = {};						   // Phase increment the steps were computed for
+	int rot_Countdown[16] = {};						   // Samples until the next resync
+	float rot_Gain[16][STS_MAX_PARTIALS] = {};	   // Fade of each partial towards Nyquist, 0 at and above it
+	bool rot_Active[16][STS_MAX_PARTIALS / 4] = {}; // Any partial of the group of 4 below Nyquist? Else the group is skipped
+	int rot_Channels = 0;		 // Number of channels the rotators are running for, -1 while all play the baked table
+
+	// The phase shift of a partial rotates its projection from the rotator: 5 * level * sin(x + shift) = sin(x) * 5 * level * cos(shift) + cos(x) * 5 * level * sin(shift)
+	float hrm_Sin_Weight[STS_MAX_PARTIALS] = {}, hrm_Cos_Weight[STS_MAX_PARTIALS] = {};
+
+	// Reads the sine table at 4 fixed point phases
+	simd::float_4 STS_My_Sine(simd::int32_4 phase, int interpolation)
+	{
+		simd::int32_4 index;
+		simd::float_4 frac;
+
+		// The top bits of the fixed point phase are the index in the wave table
+		index = STS_Wave_Index(phase, &frac);
 
-	// Maps phase & phase shift to an index in the wave table
-	float STS_My_Sine(float phase, float phase_shift)
+		return (STS_Wave_Sample(sine_wave_lookup_table.get(), index, frac, interpolation));
+	}
+
+	// Sets the rotators of a channel from the exact phase at the next sample
+	void STS_Reset_Rotators(int channel)
+	{
+		rot_Inc[channel] = 0;
+		rot_Countdown[channel] = 0;
+	}
+
+	// Sets all rotators from the exact phase at the next sample
+	void STS_Reset_Rotators()
+	{
+		for (int channel = 0; channel < 16; channel++)
+			STS_Reset_Rotators(channel);
+	}
+
+	// Live synthesis of one channel: adds up all partials from their rotators, 4 at a time
+	float STS_My_Partials(int channel, uint32_t inc)
+	{
+		simd::float_4 out = 0.f, rc, rs, t, gain;
+		simd::int32_4 angle, mult;
+		bool resync, active;
+		int i;
+
+		// New frequency? Then new steps for all partials. The table reads are cubic, as their errors add up from sample to sample
+		// Partials past Nyquist would fold back as aliasing, so they fade out over a band below it and are skipped above it
+		if (inc != rot_Inc[channel])
+		{
+			rot_Inc[channel] = inc;
+			for (i = 0; i < hrm_Num_Partials; i += 4)
+			{
+				mult = simd::int32_4::load((int32_t *)&hrm_Multiplication[i]);
+				angle = mult * (int32_t)inc;
+				(0.2f * STS_My_Sine(angle + STS_QUARTER_CYCLE, STS_INTERPOLATE_CUBIC)).store(&rot_Step_Cos[channel][i]);
+				(0.2f * STS_My_Sine(angle, STS_INTERPOLATE_CUBIC)).store(&rot_Step_Sin[channel][i]);
+
+				gain = simd::clamp((0.5f - simd::float_4(mult) * ((float)inc * (1.f / 4294967296.f))) * (1.f / STS_NYQUIST_FADE), simd::float_4(0.f), simd::float_4(1.f));
+				gain.store(&rot_Gain[channel][i]);
+
+				// A group coming back from above Nyquist has not been rotating, so set all rotators of the channel again
+				active = simd::movemask(gain > 0.f) != 0;
+				if (active && !rot_Active[channel][i / 4])
+					rot_Countdown[channel] = 0;
+				rot_Active[channel][i / 4] = active;
+			}
+		}
+
+		resync = --rot_Countdown[channel] <= 0;
+		if (resync)
+			rot_Countdown[channel] = STS_ROTATOR_RESYNC;
+
+		for (i = 0; i < hrm_Num_Partials; i += 4)
+		{
+			if (!rot_Active[channel][i / 4])
+				continue;
+
+			if (resync)
+			{
+				angle = simd::int32_4::load((int32_t *)&hrm_Multiplication[i]) * (int32_t)phase[channel];
+				rc = 0.2f * STS_My_Sine(angle + STS_QUARTER_CYCLE, STS_INTERPOLATE_CUBIC);
+				rs = 0.2f * STS_My_Sine(angle, STS_INTERPOLATE_CUBIC);
+			}
+			else
+			{
+				rc = simd::float_4::load(&rot_Cos[channel][i]);
+				rs = simd::float_4::load(&rot_Sin[channel][i]);
+				t = rc * simd::float_4::load(&rot_Step_Cos[channel][i]) - rs * simd::float_4::load(&rot_Step_Sin[channel][i]);
+				rs = rs * simd::float_4::load(&rot_Step_Cos[channel][i]) + rc * simd::float_4::load(&rot_Step_Sin[channel][i]);
+				rc = t;
+			}
+			rc.store(&rot_Cos[channel][i]);
+			rs.store(&rot_Sin[channel][i]);
+
+			out += (rs * simd::float_4::load(&hrm_Sin_Weight[i]) + rc * simd::float_4::load(&hrm_Cos_Weight[i])) * simd::float_4::load(&rot_Gain[channel][i]);
+		}
+
+		return (out[0] + out[1] + out[2] + out[3]);
+	}
+
+	// Reads the baked table, the phase shifts of the partials are in the table
+	float STS_My_Baked(const STS_Wavetable *baked_wave, uint32_t phase)
 	{
 		int index;
+		float frac;
 
-		// Compute the index by mapping phase + phase_shift across the total number of samples in the wave table
-		index = (int)((phase + phase_shift) * STS_NUM_WAVE_SAMPLES);
-		index = index % STS_NUM_WAVE_SAMPLES;
+		index = STS_Wave_Index(phase, &frac);
 
-		return (sine_wave_lookup_table[index]);
+		return (STS_Wave_Sample(baked_wave, index, frac, interpolation));
 	}
 
-	void InitSine_Waves()
+	// The same for 4 poly channels at a time
+	simd::float_4 STS_My_Baked(const STS_Wavetable *baked_wave, simd::int32_4 phase)
+	{
+		simd::int32_4 index;
+		simd::float_4 frac;
+
+		index = STS_Wave_Index(phase, &frac);
+
+		return (STS_Wave_Sample(baked_wave, index, frac, interpolation));
+	}
+
+	// Morphs through count snapshots at 4 fixed point phases. 0V plays the first snapshot, 10V the last, in between is a crossfade of the nearest two
+	// Each channel plays the level of the snapshots that keeps its partials below Nyquist, fading into the next one as the pitch rises.
+	// The levels step by octaves of the fundamental like the mipmaps of the VCOs, so STS_Mipmap_Level() gives the level and fade,
+	// for a fundamental as many times its base frequency as the largest multiplication is towards the fade band below Nyquist
+	simd::float_4 STS_My_Morph(const STS_Hrm_Morph_Levels *morph_levels, int count, simd::float_4 cv, simd::int32_4 phase, simd::int32_4 inc)
 	{
+		const STS_Wavetable *from[4], *to[4];
+		simd::float_4 position, frac, fade, out;
+		simd::int32_4 slot, index, level;
 		int i;
 
-		// Populate the sine wave table
-		// Filled with a full sine cycle, multiplied by 5.0 to reflect the default +/- 5V audio output levels
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		position = simd::clamp(0.1f * cv, simd::float_4(0.f), simd::float_4(1.f)) * (float)(count - 1);
+		slot = simd::int32_4(position);
+
+		STS_Mipmap_Level(simd::float_4(inc) * (STS_HRM_MAX_MULT * STS_MIPMAP_BASE_FREQ / (0.5f - STS_NYQUIST_FADE) / 4294967296.f), &level, &fade);
+		fade = simd::ifelse(simd::float_4(level) > (float)(STS_MORPH_LEVELS - 2), simd::float_4(1.f), fade);
+		level = simd::int32_4(simd::fmin(simd::float_4(level), simd::float_4((float)(STS_MORPH_LEVELS - 2))));
+
+		index = STS_Wave_Index(phase, &frac);
+
+		for (i = 0; i < 4; i++)
+		{
+			from[i] = morph_levels[slot[i]][level[i]];
+			to[i] = morph_levels[std::min(slot[i] + 1, count - 1)][level[i]];
+		}
+		out = simd::crossfade(STS_Wave_Sample(from, index, frac, interpolation), STS_Wave_Sample(to, index, frac, interpolation), position - simd::float_4(slot));
+
+		// Only while a channel is fading into its next level
+		if (simd::movemask(fade > 0.f))
 		{
-			sine_wave_lookup_table[i] = 5.0f * std::sin(M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES));
+			for (i = 0; i < 4; i++)
+			{
+				from[i] = morph_levels[slot[i]][level[i] + 1];
+				to[i] = morph_levels[std::min(slot[i] + 1, count - 1)][level[i] + 1];
+			}
+			out = simd::crossfade(out, simd::crossfade(STS_Wave_Sample(from, index, frac, interpolation), STS_Wave_Sample(to, index, frac, interpolation), position - simd::float_4(slot)), fade);
 		}
+
+		return (out);
+	}
+
+	// Stores the partials of the panel and the expanders as they are now in a slot of the snapshot bank
+	void Store_Snapshot(int slot)
+	{
+		STS_Hrm_Timbre *snapshot = &hrm_Snapshots[slot];
+
+		snapshot->stored = true;
+		snapshot->num = hrm_Num_Partials;
+		for (int i = 0; i < STS_MAX_PARTIALS; i++)
+		{
+			snapshot->partials[i].level = (i < hrm_Num_Partials ? hrm_Lvl[i] : 0.f);
+			snapshot->partials[i].multiplication = (i < hrm_Num_Partials ? hrm_Multiplication[i] : 0);
+			snapshot->partials[i].phase_shift = (i < hrm_Num_Partials ? hrm_Phase_Shift[i] : 0);
+		}
+		hrm_Morph.Set(hrm_Snapshots);
+	}
+
+	void Clear_Snapshot(int slot)
+	{
+		hrm_Snapshots[slot] = STS_Hrm_Timbre();
+		hrm_Morph.Set(hrm_Snapshots);
+	}
+
+	// Custom OnReset() to set some default values
+	void onReset() override
+	{
+		interpolation = STS_INTERPOLATE_LINEAR;
+		synthesis = STS_SYNTHESIS_LIVE;
+		for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+			hrm_Snapshots[i] = STS_Hrm_Timbre();
+		hrm_Morph.Set(hrm_Snapshots);
+	}
+
+	void InitSine_Waves()
+	{
+		// Get the sine wave table from the plugin-wide cache
+		sine_wave_lookup_table = STS_Get_Wavetable(STS_WAVE_SINE);
 	}
 
 	Harmoblender()
@@ -99,7 +722,7 @@ struct Harmoblender : Module
 
 			(void)sprintf(name, "Harmonic %d Multiplication", i + 1);
 			fmt = name;
-			configParam(HRM_MULT_PARAMS + i, 0.f, 32.f, float(i + 1), fmt);
+			configParam(HRM_MULT_PARAMS + i, 0.f, (float)STS_HRM_MAX_MULT, float(i + 1), fmt);
 			getParamQuantity(HRM_MULT_PARAMS + i)->snapEnabled = true;
 
 			(void)sprintf(name, "Harmonic %d Level CV (0..10V)", i + 1);
@@ -116,16 +739,43 @@ struct Harmoblender : Module
 		configInput(V_OCT_IN_INPUT, "Pitch (V//Oct)");
 		configInput(PITCH_IN_PARAM, "Pitch Modulation");
 		configParam(LVL_OUT_PARAM, 0.f, 1.f, 0.5f, "Ouput Level");
+		configInput(RESYNTH_INPUT, "Resynthesis (audio)");
+		configInput(MORPH_INPUT, "Snapshot Morph (0..10V)");
 		configOutput(OUTPUT_OUTPUT, "Audio");
 
+		// The expanders write into these
+		rightExpander.producerMessage = &hrm_Messages[0];
+		rightExpander.consumerMessage = &hrm_Messages[1];
+
 		InitSine_Waves();
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		int i = 0;				 // used to loop through harmonics
-		float temp_Out = 0.f;	 // temp output for looping through harmonics
-		float pitch_param = 0.f; // Pitch parameter
+		int i = 0;								 // used to loop through harmonics
+		float temp_Out = 0.f;					 // temp output for looping through harmonics
+		float pitch_param = 0.f;				 // Pitch parameter
+		bool cv_Connected = false;				 // Any level or phase CV patched?
+		uint32_t mult;							 // Multiplication factor of a harmonic
+		uint32_t max_Mult = 0;					 // Largest multiplication factor of the harmonics with a level
+		uint32_t max_inc = 0;					 // Largest phase increment of all channels
+		uint32_t min_inc = UINT32_MAX;			 // Smallest phase increment of all channels
+		float max_Cycles;						 // Cycles per sample of the highest partial, per unit of phase increment
+		bool all_Baked = false;					 // All channels play the baked table?
+		bool mult_Changed = false;				 // Any multiplication factor changed?
+		const STS_Wavetable *baked_wave = NULL; // Table with all partials, NULL to compute them live
+		simd::int32_4 poly_inc;					 // Phase increments of 4 poly channels
+		simd::int32_4 shift;
+		simd::float_4 level;
+		Module *expander;						 // Walks the expanders on the right
+		const STS_Hrm_Expander_Message *message = (const STS_Hrm_Expander_Message *)rightExpander.consumerMessage;
+		int num_banks = 0;						 // Number of expanders
+		int b, j;
+		STS_Hrm_Analyzer *analyzer;				 // Analyzer of the resynthesis input, NULL while it is not there
+		const STS_Hrm_Snapshot *snapshot;		 // Latest analysis of the resynthesis input
+		float glide;							 // Smoothing of the resynthesis per sample
+		const STS_Hrm_Morph_Levels *morph_levels; // Tables of the stored snapshots
+		int morph_Count;						 // Number of stored snapshots
 
 		// Get all the relevant values from the module UI
 
@@ -136,17 +786,77 @@ struct Harmoblender : Module
 		for (i = 0; i < 16; i++)
 		{
 			// Compute the phase shift as per the controls. Assume it is always in [0..1)]
+			if (getInput(HRM_PHASE_INPUTS + i).isConnected() || getInput(HRM_LVL_INPUTS + i).isConnected())
+				cv_Connected = true;
 			if (getInput(HRM_PHASE_INPUTS + i).isConnected())
-				hrm_Phase_Shift[i] = abs(0.1f * getInput(HRM_PHASE_INPUTS + i).getVoltage()) + getParam(HRM_PHASE_PARAMS + i).getValue();
+				hrm_Phase_Shift[i] = STS_Fixed_Phase(abs(0.1f * getInput(HRM_PHASE_INPUTS + i).getVoltage()) + getParam(HRM_PHASE_PARAMS + i).getValue());
 			else
-				hrm_Phase_Shift[i] = getParam(HRM_PHASE_PARAMS + i).getValue();
+				hrm_Phase_Shift[i] = STS_Fixed_Phase(getParam(HRM_PHASE_PARAMS + i).getValue());
 			// Compute the level as per the controls. Assume it is always in [0..1)]
 			if (getInput(HRM_LVL_INPUTS + i).isConnected())
 				hrm_Lvl[i] = 0.1f * getInput(HRM_LVL_INPUTS + i).getVoltage();
 			else
 				hrm_Lvl[i] = getParam(HRM_LVL_PARAMS + i).getValue();
 			// Get the multiplication factors
-			hrm_Multiplication[i] = getParam(HRM_MULT_PARAMS + i).getValue();
+			mult = (uint32_t)getParam(HRM_MULT_PARAMS + i).getValue();
+			if (mult != hrm_Multiplication[i])
+				mult_Changed = true;
+			hrm_Multiplication[i] = mult;
+		}
+
+		// Add the partials of the expanders. Another module in between ends the chain. Partials past the last expander are not used
+		for (expander = rightExpander.module; expander && expander->model == modelHarmoblender_Expander && num_banks < STS_HRM_MAX_BANKS; expander = expander->rightExpander.module)
+			num_banks++;
+		if (num_banks != hrm_Num_Banks)
+			mult_Changed = true;
+		hrm_Num_Banks = num_banks;
+		hrm_Num_Partials = STS_HRM_BANK_PARTIALS * (1 + num_banks);
+
+		for (b = 0; b < num_banks; b++)
+		{
+			for (i = 0; i < STS_HRM_BANK_PARTIALS; i++)
+			{
+				j = STS_HRM_BANK_PARTIALS * (1 + b) + i;
+				hrm_Lvl[j] = message->bank[b].level[i];
+				hrm_Phase_Shift[j] = message->bank[b].phase_shift[i];
+				mult = message->bank[b].multiplication[i];
+				if (mult != hrm_Multiplication[j])
+					mult_Changed = true;
+				hrm_Multiplication[j] = mult;
+			}
+			if (message->bank[b].cv_Connected)
+				cv_Connected = true;
+		}
+
+		// Resynthesis: the levels and phase shifts of all partials glide towards the latest analysis of the input
+		// The phase shifts glide the short way round, as the difference wraps around in fixed point
+		// Until the worker thread has allocated the analyzer, the partials hold their last resynthesis
+		analyzer = hrm_Analyzer.Get(getInput(RESYNTH_INPUT).isConnected());
+		if (getInput(RESYNTH_INPUT).isConnected())
+		{
+			cv_Connected = true;
+			if (analyzer)
+			{
+				analyzer->Push(getInput(RESYNTH_INPUT).getVoltageSum(), args.sampleRate, hrm_Multiplication, hrm_Num_Partials);
+				snapshot = analyzer->Get();
+				glide = args.sampleTime * (1.f / STS_ANALYSIS_SMOOTHING);
+				for (i = 0; i < hrm_Num_Partials; i++)
+				{
+					rsy_Lvl[i] += (snapshot->level[i] - rsy_Lvl[i]) * glide;
+					rsy_Phase_Shift[i] += (int32_t)((float)(int32_t)(snapshot->phase_shift[i] - rsy_Phase_Shift[i]) * glide);
+				}
+			}
+			for (i = 0; i < hrm_Num_Partials; i++)
+			{
+				hrm_Lvl[i] = rsy_Lvl[i];
+				hrm_Phase_Shift[i] = rsy_Phase_Shift[i];
+			}
+		}
+
+		for (i = 0; i < hrm_Num_Partials; i++)
+		{
+			if (hrm_Lvl[i] != 0.f && hrm_Multiplication[i] > max_Mult)
+				max_Mult = hrm_Multiplication[i];
 		}
 
 		// Is the V-In connected?
@@ -170,54 +880,191 @@ struct Harmoblender : Module
 			else if (freq > 20000.f)
 				freq = 20000.f;
 
-			// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-			phase[0] += freq * args.sampleTime;
-			if (phase[0] >= 1.f)
-				phase[0] -= 1.f;
+			// Accumulate the phase in fixed point, it wraps around by itself at the end of the cycle
+			channel_inc[0] = STS_Fixed_Phase(freq * args.sampleTime);
+			phase[0] += channel_inc[0];
+			max_inc = channel_inc[0];
+			min_inc = channel_inc[0];
+		}
+		else
+		{
+			// Else, compute it as per the V/Oct input for each poly channel
+			// Loop through the input channels, 4 at a time. A last group of less than 4 computes the unused channels too, they are ignored
+			pitch_param = getParam(PITCH_PARAM).getValue();
+			for (idx = 0; idx < num_channels; idx += 4)
+			{
+				// Compute the pitch as per the controls
+				poly_pitch = getInput(V_OCT_IN_INPUT).getVoltageSimd<simd::float_4>(idx);
+				poly_freq = pitch_param * dsp::approxExp2_taylor5(poly_pitch);
+
+				if (getInput(PITCH_IN_PARAM).isConnected())
+					poly_freq = poly_freq + pitch_param * getInput(PITCH_IN_PARAM).getVoltage() * FREQ_MOD_MULTIPLIER;
+
+				// limit the pitch if modulation takes it too extreme
+				poly_freq = simd::clamp(poly_freq, simd::float_4(10.f), simd::float_4(20000.f));
+
+				// Accumulate the phases in fixed point, they wrap around by themselves at the end of the cycle
+				poly_inc = STS_Fixed_Phase(poly_freq * args.sampleTime);
+				poly_inc.store((int32_t *)&channel_inc[idx]);
+				poly_phase = simd::int32_4::load((int32_t *)&phase[idx]) + poly_inc;
+				poly_phase.store((int32_t *)&phase[idx]);
+			}
+			for (idx = 0; idx < num_channels; idx++)
+			{
+				if (channel_inc[idx] > max_inc)
+					max_inc = channel_inc[idx];
+				if (channel_inc[idx] < min_inc)
+					min_inc = channel_inc[idx];
+			}
+		}
+
+		// Morphing through the snapshot bank replaces the partials: each channel crossfades between the tables of the two nearest snapshots
+		morph_Count = (getInput(MORPH_INPUT).isConnected() ? hrm_Morph.Get(&morph_levels) : 0);
+		if (morph_Count > 0)
+		{
+			rot_Channels = -1;
+			if (num_channels == 0)
+				getOutput(OUTPUT_OUTPUT).setVoltage(lvl_Multiplier * STS_My_Morph(morph_levels, morph_Count, getInput(MORPH_INPUT).getVoltage(), (int32_t)phase[0], (int32_t)channel_inc[0])[0]);
+			else
+			{
+				for (idx = 0; idx < num_channels; idx += 4)
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(lvl_Multiplier * STS_My_Morph(morph_levels, morph_Count, getInput(MORPH_INPUT).getPolyVoltageSimd<simd::float_4>(idx),
+																						   simd::int32_4::load((int32_t *)&phase[idx]), simd::int32_4::load((int32_t *)&channel_inc[idx])), idx);
+			}
+			return;
+		}
+
+		// Baked synthesis: hand the partials to the baker, it only rebakes when they changed
+		// With CV patched, or while the table for the latest knob settings is not ready, the partials are computed live
+		// The baked table holds all partials, so it aliases as soon as one of them gets near Nyquist. A channel that high computes its
+		// partials live, fading those out, the others keep playing the table. With all channels that high the baker is not handed
+		// the partials at all: that would only cost time for a table that is not played
+		max_Cycles = (float)max_Mult * (1.f / 4294967296.f);
+		if (synthesis == STS_SYNTHESIS_BAKED && !cv_Connected && max_Cycles * (float)min_inc <= 0.5f - STS_NYQUIST_FADE)
+		{
+			for (i = 0; i < hrm_Num_Partials; i++)
+			{
+				hrm_Partials[i].level = hrm_Lvl[i];
+				hrm_Partials[i].multiplication = hrm_Multiplication[i];
+				hrm_Partials[i].phase_shift = hrm_Phase_Shift[i];
+			}
+			hrm_Baker.Set_Partials(hrm_Partials, hrm_Num_Partials);
+			baked_wave = hrm_Baker.Get();
+			all_Baked = (baked_wave && max_Cycles * (float)max_inc <= 0.5f - STS_NYQUIST_FADE);
+		}
+
+		// Live synthesis: the rotators are off after changes to the partials or channels, or after all channels played the baked table
+		if (!all_Baked)
+		{
+			if (mult_Changed || num_channels != rot_Channels)
+				STS_Reset_Rotators();
 
-			// Compute the wave by adding all harmonics
-			// output to the correct channel, multiplied by the output level
-			temp_Out = 0.f;
-			for (i = 0; i < 16; i++)
+			for (i = 0; i < hrm_Num_Partials; i += 4)
 			{
-				temp_Out += hrm_Lvl[i] * STS_My_Sine(hrm_Multiplication[i] * phase[0], hrm_Phase_Shift[i]);
+				shift = simd::int32_4::load((int32_t *)&hrm_Phase_Shift[i]);
+				level = simd::float_4::load(&hrm_Lvl[i]);
+				(level * STS_My_Sine(shift + STS_QUARTER_CYCLE, STS_INTERPOLATE_LINEAR)).store(&hrm_Sin_Weight[i]);
+				(level * STS_My_Sine(shift, STS_INTERPOLATE_LINEAR)).store(&hrm_Cos_Weight[i]);
 			}
+		}
+		rot_Channels = (all_Baked ? -1 : num_channels);
+
+		// Compute the wave by adding all harmonics, or from the baked table
+		// output to the correct channel, multiplied by the output level
+		if (num_channels == 0)
+		{
+			if (baked_wave)
+				temp_Out = STS_My_Baked(baked_wave, phase[0]);
+			else
+				temp_Out = STS_My_Partials(0, channel_inc[0]);
 			getOutput(OUTPUT_OUTPUT).setVoltage(lvl_Multiplier * temp_Out);
 		}
+		else if (baked_wave)
+		{
+			// The channels too high for the table replace their read with the live partials. The others keep their rotators
+			// reset, so they start from the exact phase when they go live
+			for (idx = 0; idx < num_channels; idx += 4)
+				getOutput(OUTPUT_OUTPUT).setVoltageSimd(lvl_Multiplier * STS_My_Baked(baked_wave, simd::int32_4::load((int32_t *)&phase[idx])), idx);
+			if (!all_Baked)
+			{
+				for (idx = 0; idx < num_channels; idx++)
+				{
+					if (max_Cycles * (float)channel_inc[idx] <= 0.5f - STS_NYQUIST_FADE)
+						STS_Reset_Rotators(idx);
+					else
+						getOutput(OUTPUT_OUTPUT).setVoltage(lvl_Multiplier * STS_My_Partials(idx, channel_inc[idx]), idx);
+				}
+			}
+		}
 		else
 		{
-			// Else, compute it as per the V/Oct input for each poly channel
-			// Loop through all input channels
 			for (idx = 0; idx < num_channels; idx++)
+				getOutput(OUTPUT_OUTPUT).setVoltage(lvl_Multiplier * STS_My_Partials(idx, channel_inc[idx]), idx);
+		}
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+
+		json_object_set_new(rootJ, "Interpolation", json_integer(interpolation));
+		json_object_set_new(rootJ, "Synthesis", json_integer(synthesis));
+
+		// The snapshot bank: null for an empty slot, else a [level, phase shift in cycles, multiplication] triple per partial
+		json_t *snapshotsJ = json_array();
+		for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+		{
+			if (!hrm_Snapshots[i].stored)
 			{
-				// Compute the pitch as per the controls
-				pitch_param = getParam(PITCH_PARAM).getValue();
-				pitch = getInput(V_OCT_IN_INPUT).getVoltage(idx);
-				freq = pitch_param * std::pow(2.f, pitch);
+				json_array_append_new(snapshotsJ, json_null());
+				continue;
+			}
+			json_t *partialsJ = json_array();
+			for (int j = 0; j < hrm_Snapshots[i].num; j++)
+			{
+				json_t *partialJ = json_array();
+				json_array_append_new(partialJ, json_real(hrm_Snapshots[i].partials[j].level));
+				json_array_append_new(partialJ, json_real(hrm_Snapshots[i].partials[j].phase_shift * (1.0 / 4294967296.0)));
+				json_array_append_new(partialJ, json_integer(hrm_Snapshots[i].partials[j].multiplication));
+				json_array_append_new(partialsJ, partialJ);
+			}
+			json_array_append_new(snapshotsJ, partialsJ);
+		}
+		json_object_set_new(rootJ, "Snapshots", snapshotsJ);
 
-				if (getInput(PITCH_IN_PARAM).isConnected())
-					freq = freq + pitch_param * getInput(PITCH_IN_PARAM).getVoltage() * FREQ_MOD_MULTIPLIER;
+		return rootJ;
+	}
 
-				// limit the pitch if modulation takes it too extreme
-				if (freq < 10.f)
-					freq = 10.f;
-				else if (freq > 20000.f)
-					freq = 20000.f;
-
-				// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-				phase[idx] += freq * args.sampleTime;
-				if (phase[idx] >= 1.f)
-					phase[idx] -= 1.f;
-
-				// Compute the wave by adding all harmonics
-				// output to the correct channel, multiplied by the output level
-				temp_Out = 0.f;
-				for (i = 0; i < 16; i++)
+	void dataFromJson(json_t *rootJ) override
+	{
+		json_t *interpolationJ = json_object_get(rootJ, "Interpolation");
+		json_t *synthesisJ = json_object_get(rootJ, "Synthesis");
+
+		if (interpolationJ)
+			interpolation = json_integer_value(interpolationJ);
+		if (synthesisJ)
+			synthesis = json_integer_value(synthesisJ);
+
+		json_t *snapshotsJ = json_object_get(rootJ, "Snapshots");
+		if (snapshotsJ)
+		{
+			for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+			{
+				json_t *partialsJ = json_array_get(snapshotsJ, i);
+				hrm_Snapshots[i] = STS_Hrm_Timbre();
+				if (!partialsJ || !json_is_array(partialsJ))
+					continue;
+				hrm_Snapshots[i].stored = true;
+				hrm_Snapshots[i].num = std::min((int)json_array_size(partialsJ), STS_MAX_PARTIALS);
+				for (int j = 0; j < hrm_Snapshots[i].num; j++)
 				{
-					temp_Out += hrm_Lvl[i] * STS_My_Sine(hrm_Multiplication[i] * phase[idx], hrm_Phase_Shift[i]);
+					json_t *partialJ = json_array_get(partialsJ, j);
+					hrm_Snapshots[i].partials[j].level = json_number_value(json_array_get(partialJ, 0));
+					hrm_Snapshots[i].partials[j].phase_shift = (uint32_t)(int64_t)(json_number_value(json_array_get(partialJ, 1)) * 4294967296.0);
+					hrm_Snapshots[i].partials[j].multiplication = json_integer_value(json_array_get(partialJ, 2));
 				}
-				getOutput(OUTPUT_OUTPUT).setVoltage(lvl_Multiplier * temp_Out, idx);
 			}
+			hrm_Morph.Set(hrm_Snapshots);
 		}
 	}
 };
@@ -336,6 +1183,28 @@ struct HarmoblenderWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(108.0, 110.0)), module, Harmoblender::V_OCT_IN_INPUT));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(128.0, 110.0)), module, Harmoblender::LVL_OUT_PARAM));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(119.5, 110.0)), module, Harmoblender::OUTPUT_OUTPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(71.0, 110.0)), module, Harmoblender::RESYNTH_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(61.0, 110.0)), module, Harmoblender::MORPH_INPUT));
+	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		Harmoblender *module = getModule<Harmoblender>();
+
+		menu->addChild(new MenuSeparator);
+
+		menu->addChild(createIndexPtrSubmenuItem("Interpolation", {"None", "Linear", "Cubic"}, &module->interpolation));
+		menu->addChild(createIndexPtrSubmenuItem("Synthesis", {"Live", "Baked"}, &module->synthesis));
+
+		// The snapshot bank, played by the Snapshot Morph CV
+		menu->addChild(createSubmenuItem("Store Snapshot", "", [=](Menu *menu) {
+			for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+				menu->addChild(createMenuItem(string::f("Slot %d", i + 1), CHECKMARK(module->hrm_Snapshots[i].stored), [=]() { module->Store_Snapshot(i); }));
+		}));
+		menu->addChild(createSubmenuItem("Clear Snapshot", "", [=](Menu *menu) {
+			for (int i = 0; i < STS_NUM_SNAPSHOTS; i++)
+				menu->addChild(createMenuItem(string::f("Slot %d", i + 1), "", [=]() { module->Clear_Snapshot(i); }, !module->hrm_Snapshots[i].stored));
+		}));
 	}
 };
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <rack.hpp>
+#include <cstdint>
+#include "sts-wavetables.hpp"
+using namespace rack;
+
+// Harmoblender expanders: each one placed to the right of a Harmoblender, or of another expander, adds a bank of 16 partials
+// An expander only turns its knobs and CV into partials. It hands them to the Harmoblender through the expander message
+// double-buffer of the Harmoblender, which adds them up with its own partials on its own phases
+
+#define STS_HRM_BANK_PARTIALS 16 // Partials on each panel
+#define STS_HRM_MAX_BANKS (STS_MAX_PARTIALS / STS_HRM_BANK_PARTIALS - 1) // Expanders taken into account, more to the right are ignored
+#define STS_HRM_MAX_MULT 32 // Largest multiplication of a partial, on the panel and the expanders alike
+
+// The partials of one expander, as ready to be added up by the Harmoblender
+struct STS_Hrm_Bank
+{
+	float level[STS_HRM_BANK_PARTIALS];
+	uint32_t phase_shift[STS_HRM_BANK_PARTIALS];	// In fixed point cycles
+	uint32_t multiplication[STS_HRM_BANK_PARTIALS];
+	bool cv_Connected; // Any level or phase CV patched?
+};
+
+// The message buffer of the Harmoblender. Expander n writes bank n - 1 only, so all expanders write into the same buffer
+struct STS_Hrm_Expander_Message
+{
+	STS_Hrm_Bank bank[STS_HRM_MAX_BANKS];
+};
@@ -1,5 +1,6 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-wavetables.hpp"
 #include <math.h>
 
 struct Pulse_VCO : Module
@@ -23,6 +24,7 @@ struct Pulse_VCO : Module
 		PM_IN_INPUT,
 		VM_IN_INPUT,
 		PW_IN_INPUT,
+		SYNC_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId
@@ -41,103 +43,150 @@ struct Pulse_VCO : Module
 	const float VOLUME_MOD_MULTIPLIER = 0.1f;
 	const float PULSEWIDTH_MOD_MULTIPLIER = 0.1f;
 
-#define STS_NUM_WAVE_SAMPLES 1000
-#define STS_DEF_NUM_HARMONICS 10
+#define STS_HARMONICS_AUTO 20 // Harmonics menu entry filling each octave up to Nyquist
 
 	int bandLimited = 0;
-	int num_Harmonics = STS_DEF_NUM_HARMONICS;
-	int last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-	int menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-
-	// An array of values to represent the sine wave, as values in the range [-1.0, 1.0]. This can arguebly be regarded as a wavetable
-	float pulse_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
+	int interpolation = STS_INTERPOLATE_LINEAR;
+	int menu_num_Harmonics = STS_HARMONICS_AUTO; // Only touched by the UI thread, the audio thread gets the tables through pulse_waves
+
+	// The band-limited up ramp, shared read-only with all other instances, the pulse is the difference of 2 reads from it
+	// It is a mipmap with a table per octave, limited to the # of harmonics set in the Harmonics menu
+	// The tables are rebuilt on the worker thread by pulse_waves, process() picks up the current ones at every sample
+	STS_Wavetable_Loader pulse_waves{STS_WAVE_SAW, 0};
+	const STS_Wavetable_Set *pulse_wave_lookup_tables = NULL;
+	int mipmap_level = 0;	  // Mipmap level for the frequency being computed
+	float mipmap_fade = 0.f; // Crossfade into the next mipmap level
+	simd::int32_4 poly_mipmap_level = 0; // The same for 4 poly channels
+	simd::float_4 poly_mipmap_fade = 0.f;
+	float phase_inc = 0.f;			   // Phase increment per sample in cycles, for PolyBLEP
+	simd::float_4 poly_phase_inc = 0.f; // The same for 4 poly channels
 
 	// local class variable declarations
 	float pitch_param, phase_param, volume_param, pulsewidth_param;
-	float freq = 0.f, pitch = 0.f, phase_shift = 0.f, volume_out = 0.f, pulse_width = 0.5;
+	float freq = 0.f, pitch = 0.f, volume_out = 0.f, pulse_width = 0.5;
+	uint32_t phase_shift = 0;	   // Phase shift in fixed point cycles
+	uint32_t pulse_width_fixed = 0; // Pulse width in fixed point cycles
+	simd::float_4 poly_pulse_width = 0.5f; // The same for 4 poly channels
+	simd::int32_4 poly_pulse_width_fixed = 0;
 	float freq_mod = 0.f, phase_mod = 0.f, volume_mod = 0.f, pulsewidth_mod = 0.f;
 	float freq_mod_attn = 0.f, phase_mod_attn = 0.f, volume_mod_attn = 0.f, pulsewidth_mod_attn = 0.f;
 	int num_channels, idx;
 
+	// The poly channels are computed 4 at a time
+	simd::float_4 poly_pitch, poly_freq;
+	simd::int32_4 poly_phase;
+
+	// Hard sync of the sample being computed. The jump at the reset is that of the wave without the PolyBLEP corrections
+	int sync_band;
+	bool sync_edge;
+	float sync_since, sync_jump;
+	uint32_t edge_phase;
+	simd::float_4 poly_sync_edge, poly_sync_since, poly_sync_jump, poly_wave;
+	simd::int32_4 poly_edge_phase;
+
 	// Array of 16 phases to accomodate for polyphony
-	float phase[16] = {};
+	uint32_t phase[16] = {};
+
+	// Hard sync: the last sample of the master and the sample held back for the PolyBLEP, per poly channel
+	float sync_prev[16] = {};
+	float sync_held[16] = {};
+	int sync_Channels = -1; // Channel count they were set for, -1 while the sync input is not patched
 
 	// Maps phase & phase shift to an index in the wave table or compute a mathematical pulse
-	float STS_My_Pulse(float phase, float phase_shift)
+	float STS_My_Pulse(uint32_t phase, uint32_t phase_shift, int band)
 	{
 		int index;
-		float pulse_pos;
-		// Band-unlimited?
-		if (bandLimited)
-		{
+		float frac;
+		uint32_t pulse_pos;
+		float t, pulse;
 
-			// Compute the index by mapping phase + phase_shift across the total number of samples in the wave table
-			index = (int)((phase + phase_shift) * STS_NUM_WAVE_SAMPLES);
-			index = index % STS_NUM_WAVE_SAMPLES;
+		// Compute the pulse position by mapping phase + phase_shift across the cycle with the pulse width as cut-off
+		pulse_pos = phase + phase_shift;
 
-			return (pulse_wave_lookup_table[index]);
+		// PolyBLEP needs no table: the pulse jumps up by 10V at the start of the cycle and down by 10V at the pulse width
+		if (band == STS_BAND_POLYBLEP)
+		{
+			t = STS_Phase_Cycles(pulse_pos);
+			pulse = (pulse_pos < pulse_width_fixed ? 5.f : -5.f);
+			return (pulse + 10.f * (STS_PolyBLEP(t, phase_inc) - STS_PolyBLEP(STS_Phase_Cycles(pulse_pos - pulse_width_fixed), phase_inc)));
+		}
+		// Band-limited?
+		else if (band == STS_BAND_LIMITED)
+		{
+			// An up ramp delayed by the pulse width minus the ramp itself is a pulse of that width, as band-limited as the ramps.
+			// It lacks the DC of the pulse, which is added back at the level of the ramps
+			index = STS_Wave_Index(pulse_pos - pulse_width_fixed, &frac);
+			pulse = STS_Mipmap_Sample(pulse_wave_lookup_tables->up, mipmap_level, mipmap_fade, index, frac, interpolation);
+			index = STS_Wave_Index(pulse_pos, &frac);
+			pulse -= STS_Mipmap_Sample(pulse_wave_lookup_tables->up, mipmap_level, mipmap_fade, index, frac, interpolation);
+
+			return (pulse + (10.f * pulse_width - 5.f) * (1.f / STS_SAW_GIBBS));
 		}
 		else
 		{
-			// Compute the pulse position by mapping phase + phase_shift across the 0..1 range with the pulse width as cut-off
-			pulse_pos = phase + phase_shift;
-			if (pulse_pos > 1.0f)
-				pulse_pos -= 1.0f;
-
-			if (pulse_pos < pulse_width)
+			if (pulse_pos < pulse_width_fixed)
 				return (5.0f);
 			else
 				return (-5.0f);
 		}
 	}
 
-	// Custom OnReset() to initialize wave tables and set some default values
-	void onReset() override
+	// The same for 4 poly channels at a time, each with its own pulse width
+	simd::float_4 STS_My_Pulse(simd::int32_4 phase, uint32_t phase_shift, int band)
 	{
-		bandLimited = 0;
-		num_Harmonics = STS_DEF_NUM_HARMONICS;
-		menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		InitPulse_Waves();
-	}
+		simd::int32_4 index;
+		simd::float_4 frac;
+		simd::int32_4 pulse_pos;
+		simd::float_4 pulse;
 
-	void
-	InitPulse_Waves()
-	{
-		int i, j;
-		float iter, harmonic, h_factor, max_harmonic;
+		pulse_pos = phase + (int32_t)phase_shift;
 
-		// Using harmonic sine waves to mimic a band-limited square wave to limit aliases
-		// Square = odd harmonics only, ¹/3 of 3rd, ¹/5 of 5th &c. (⅟harmonic)
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		if (band == STS_BAND_POLYBLEP)
 		{
-			iter = M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES);
-			pulse_wave_lookup_table[i] = 0.0f;
-
-			// Now loop through the odd harmonics until...
-			for (j = 1; j <= num_Harmonics * 2; j += 2)
-			{
-				h_factor = (float)j;
-				harmonic = std::sin(h_factor * iter) / (h_factor);
-				pulse_wave_lookup_table[i] = pulse_wave_lookup_table[i] + harmonic;
-			}
+			// The pulse position is compared unsigned, flipping the sign bits turns that into the signed compare SIMD has
+			pulse = simd::ifelse(simd::float_4::cast((pulse_pos ^ INT32_MIN) < (poly_pulse_width_fixed ^ INT32_MIN)), simd::float_4(5.f), simd::float_4(-5.f));
+			return (pulse + 10.f * (STS_PolyBLEP(STS_Phase_Cycles(pulse_pos), poly_phase_inc) - STS_PolyBLEP(STS_Phase_Cycles(pulse_pos - poly_pulse_width_fixed), poly_phase_inc)));
 		}
-
-		// Now fnd the max harmonic value to correct the output voltage between -5.0 and 5.0 V
-		// Find tha largest harmoic first
-		max_harmonic = 0.0f;
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		else if (band == STS_BAND_LIMITED)
 		{
-			if (pulse_wave_lookup_table[i] > max_harmonic)
-				max_harmonic = pulse_wave_lookup_table[i];
+			index = STS_Wave_Index(pulse_pos - poly_pulse_width_fixed, &frac);
+			pulse = STS_Mipmap_Sample(pulse_wave_lookup_tables->up, poly_mipmap_level, poly_mipmap_fade, index, frac, interpolation);
+			index = STS_Wave_Index(pulse_pos, &frac);
+			pulse -= STS_Mipmap_Sample(pulse_wave_lookup_tables->up, poly_mipmap_level, poly_mipmap_fade, index, frac, interpolation);
+
+			return (pulse + (10.f * poly_pulse_width - 5.f) * (1.f / STS_SAW_GIBBS));
 		}
-		// Then correct...
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		else
 		{
-			pulse_wave_lookup_table[i] *= (5.0f / max_harmonic);
+			return (simd::ifelse(simd::float_4::cast((pulse_pos ^ INT32_MIN) < (poly_pulse_width_fixed ^ INT32_MIN)), simd::float_4(5.f), simd::float_4(-5.f)));
 		}
 	}
 
+	// Custom OnReset() to initialize wave tables and set some default values
+	void onReset() override
+	{
+		bandLimited = 0;
+		interpolation = STS_INTERPOLATE_LINEAR;
+		SetNum_Harmonics(STS_HARMONICS_AUTO);
+	}
+
+	// Called from the UI thread when the Harmonics menu changes. The band-limited tables are rebuilt on the worker thread,
+	// the audio thread keeps playing the current tables until the new ones are ready
+	void SetNum_Harmonics(int menu_num)
+	{
+		menu_num_Harmonics = clamp(menu_num, 0, STS_HARMONICS_AUTO);
+		if (menu_num_Harmonics == STS_HARMONICS_AUTO)
+			pulse_waves.SetMax_Harmonics(0);
+		else
+			pulse_waves.SetMax_Harmonics(2 * menu_num_Harmonics + 1); // The menu counts the odd harmonics of the square wave
+	}
+
+	// The mipmap levels depend on Nyquist, so rebuild them for the new sample rate
+	void onSampleRateChange(const SampleRateChangeEvent &e) override
+	{
+		pulse_waves.SetSample_Rate(e.sampleRate);
+	}
+
 	Pulse_VCO()
 	{
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -154,20 +203,14 @@ struct Pulse_VCO : Module
 		configInput(PM_IN_INPUT, "Phase modulation");
 		configInput(VM_IN_INPUT, "Volume modulation");
 		configInput(PW_IN_INPUT, "Pulse-width modulation");
+		configInput(SYNC_INPUT, "Hard sync");
 		configOutput(OUTPUT_OUTPUT, "Audio Out");
-
-		InitPulse_Waves();
 	}
 
 	void process(const ProcessArgs &args) override
 	{
-		// Check if we need to recompute the wave tables
-		if (last_menu_num_Harmonics != menu_num_Harmonics)
-		{
-			num_Harmonics = menu_num_Harmonics + 1;
-			InitPulse_Waves();
-			last_menu_num_Harmonics = menu_num_Harmonics;
-		}
+		// Pick up the band-limited tables, swapping in new ones if the worker thread has finished it
+		pulse_wave_lookup_tables = &pulse_waves.Get();
 
 		// Get all the values from the module UI
 		pitch_param = getParam(PITCH_PARAM).getValue();
@@ -189,21 +232,23 @@ struct Pulse_VCO : Module
 		else
 			volume_out = volume_param;
 
-		// Compute the phase shift as per the controls. Make sure it is not negative, as this may happen with modulation with a bipolar signal
+		// Compute the phase shift as per the controls, in fixed point. A negative shift, as may happen with modulation with a bipolar signal, wraps around by itself
 		if (getInput(PM_IN_INPUT).isConnected())
-		{
-			phase_shift = phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER;
-			if (phase_shift < 0.0f)
-				phase_shift += 1.0f;
-		}
+			phase_shift = STS_Fixed_Phase(phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER);
 		else
-			phase_shift = phase_param;
+			phase_shift = STS_Fixed_Phase(phase_param);
 
 		// Compute the pulse width output as per the controls
 		if (getInput(PW_IN_INPUT).isConnected())
 			pulse_width = 0.01f * pulsewidth_param + pulsewidth_mod * pulsewidth_mod_attn * PULSEWIDTH_MOD_MULTIPLIER;
 		else
 			pulse_width = 0.01f * pulsewidth_param; // pulse width param is a %
+		// In fixed point, kept within the cycle: modulation beyond it gives a constant high or low level
+		pulse_width = clamp(pulse_width, 0.f, 0.9999999f);
+		pulse_width_fixed = STS_Fixed_Phase(pulse_width);
+
+		// Hard sync reads the wave without the PolyBLEP corrections around the reset, they assume the wave has no jump there
+		sync_band = (bandLimited == STS_BAND_POLYBLEP ? STS_BAND_UNLIMITED : bandLimited);
 
 		// Is the V-In connected?
 		num_channels = getInput(V_OCT_IN_INPUT).getChannels();
@@ -225,44 +270,109 @@ struct Pulse_VCO : Module
 			else if (freq > 20000.f)
 				freq = 20000.f;
 
-			// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-			phase[0] += freq * args.sampleTime;
-			if (phase[0] >= 1.f)
-				phase[0] -= 1.f;
+			// Select the band-limited tables for this frequency
+			STS_Mipmap_Level(freq, &mipmap_level, &mipmap_fade);
+
+			phase_inc = freq * args.sampleTime;
 
-			// Compute the wave via the wave table,
-			// output to the correct channel, multiplied by the output volume
-			getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Pulse(phase[0], phase_shift));
+			if (getInput(SYNC_INPUT).isConnected())
+			{
+				// Just patched? Then start from the master and the wave as they are now. An edge against the last level of an earlier patch
+				// would be a false one, and the sample held back a stale one
+				if (sync_Channels != num_channels)
+				{
+					sync_prev[0] = getInput(SYNC_INPUT).getVoltage();
+					sync_held[0] = STS_My_Pulse(phase[0], phase_shift, bandLimited);
+				}
+
+				// Accumulate the phase, resetting it at a rising edge of the master, and smooth the jump the reset makes in the wave
+				sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getVoltage(), &sync_prev[0], &sync_since);
+				edge_phase = STS_Sync_Phase(&phase[0], phase_inc, sync_edge, sync_since);
+				if (sync_edge)
+				{
+					sync_jump = STS_My_Pulse(0, phase_shift, sync_band) - STS_My_Pulse(edge_phase, phase_shift, sync_band);
+					getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_Sync_BLEP(STS_My_Pulse(phase[0], phase_shift, sync_band), true, sync_jump, sync_since, &sync_held[0]));
+				}
+				else
+					getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_Sync_BLEP(STS_My_Pulse(phase[0], phase_shift, bandLimited), false, 0.f, 0.f, &sync_held[0]));
+			}
+			else
+			{
+				// Accumulate the phase in fixed point, it wraps around by itself at the end of the cycle
+				phase[0] += STS_Fixed_Phase(phase_inc);
+
+				// Compute the wave via the wave table,
+				// output to the correct channel, multiplied by the output volume
+				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Pulse(phase[0], phase_shift, bandLimited));
+			}
 		}
 		else
 		{
 			// Else, compute it as per the V/Oct input for each poly channel
-			// Loop through all input channels
-			for (idx = 0; idx < num_channels; idx++)
+			// Loop through the input channels, 4 at a time. A last group of less than 4 computes the unused channels too, they are ignored
+			for (idx = 0; idx < num_channels; idx += 4)
 			{
-				pitch = getInput(V_OCT_IN_INPUT).getVoltage(idx);
-				freq = pitch_param * std::pow(2.f, pitch);
+				poly_pitch = getInput(V_OCT_IN_INPUT).getVoltageSimd<simd::float_4>(idx);
+				poly_freq = pitch_param * dsp::approxExp2_taylor5(poly_pitch);
 
 				// Compute the pitch as per the controls
 				if (getInput(FM_IN_INPUT).isConnected())
-					freq = freq + freq * freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER;
+					poly_freq = poly_freq + poly_freq * (freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER);
 
 				// limit the pitch if modulation takes it too extreme
-				if (freq < 10.f)
-					freq = 10.f;
-				else if (freq > 20000.f)
-					freq = 20000.f;
-
-				// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-				phase[idx] += freq * args.sampleTime;
-				if (phase[idx] >= 1.f)
-					phase[idx] -= 1.f;
-
-				// Compute the wave via the wave table,
-				// output to the correct channel, multiplied by the output volume
-				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Pulse(phase[idx], phase_shift), idx);
+				poly_freq = simd::clamp(poly_freq, simd::float_4(10.f), simd::float_4(20000.f));
+
+				// Select the band-limited tables for these frequencies
+				STS_Mipmap_Level(poly_freq, &poly_mipmap_level, &poly_mipmap_fade);
+
+				// Compute the pulse widths as per the controls, one per channel with a polyphonic pulse-width modulation
+				if (getInput(PW_IN_INPUT).isConnected())
+					poly_pulse_width = 0.01f * pulsewidth_param + getInput(PW_IN_INPUT).getPolyVoltageSimd<simd::float_4>(idx) * (pulsewidth_mod_attn * PULSEWIDTH_MOD_MULTIPLIER);
+				else
+					poly_pulse_width = pulse_width;
+				poly_pulse_width = simd::clamp(poly_pulse_width, simd::float_4(0.f), simd::float_4(0.9999999f));
+				poly_pulse_width_fixed = STS_Fixed_Phase(poly_pulse_width);
+
+				poly_phase_inc = poly_freq * args.sampleTime;
+
+				if (getInput(SYNC_INPUT).isConnected())
+				{
+					// Just patched, or a new channel count? Then start from the master and the waves as they are now, as above
+					if (sync_Channels != num_channels)
+					{
+						getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx).store(&sync_prev[idx]);
+						STS_My_Pulse(simd::int32_4::load((int32_t *)&phase[idx]), phase_shift, bandLimited).store(&sync_held[idx]);
+					}
+
+					// The same per channel, a monophonic master syncs all channels
+					poly_sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx), &sync_prev[idx], &poly_sync_since);
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]);
+					poly_edge_phase = STS_Sync_Phase(&poly_phase, poly_phase_inc, poly_sync_edge, poly_sync_since);
+					poly_phase.store((int32_t *)&phase[idx]);
+					poly_wave = STS_My_Pulse(poly_phase, phase_shift, bandLimited);
+					poly_sync_jump = 0.f;
+					if (simd::movemask(poly_sync_edge))
+					{
+						poly_sync_jump = STS_My_Pulse(simd::int32_4(0), phase_shift, sync_band) - STS_My_Pulse(poly_edge_phase, phase_shift, sync_band);
+						if (sync_band != bandLimited)
+							poly_wave = simd::ifelse(poly_sync_edge, STS_My_Pulse(poly_phase, phase_shift, sync_band), poly_wave);
+					}
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_Sync_BLEP(poly_wave, poly_sync_edge, poly_sync_jump, poly_sync_since, &sync_held[idx]), idx);
+				}
+				else
+				{
+					// Accumulate the phases in fixed point, they wrap around by themselves at the end of the cycle
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]) + STS_Fixed_Phase(poly_phase_inc);
+					poly_phase.store((int32_t *)&phase[idx]);
+
+					// Compute the wave via the wave table,
+					// output to the correct channels, multiplied by the output volume
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_My_Pulse(poly_phase, phase_shift, bandLimited), idx);
+				}
 			}
 		}
+
+		sync_Channels = (getInput(SYNC_INPUT).isConnected() ? num_channels : -1);
 	}
 
 	json_t *dataToJson() override
@@ -270,6 +380,7 @@ struct Pulse_VCO : Module
 		json_t *rootJ = json_object();
 
 		json_object_set_new(rootJ, "Band", json_integer(bandLimited));
+		json_object_set_new(rootJ, "Interpolation", json_integer(interpolation));
 		json_object_set_new(rootJ, "Harmonics", json_integer(menu_num_Harmonics));
 
 		return rootJ;
@@ -278,12 +389,15 @@ struct Pulse_VCO : Module
 	void dataFromJson(json_t *rootJ) override
 	{
 		json_t *bandLimitedJ = json_object_get(rootJ, "Band");
+		json_t *interpolationJ = json_object_get(rootJ, "Interpolation");
 		json_t *harmonicsJ = json_object_get(rootJ, "Harmonics");
 
 		if (bandLimitedJ)
 			bandLimited = json_integer_value(bandLimitedJ);
+		if (interpolationJ)
+			interpolation = json_integer_value(interpolationJ);
 		if (harmonicsJ)
-			menu_num_Harmonics = json_integer_value(harmonicsJ);
+			SetNum_Harmonics(json_integer_value(harmonicsJ));
 	}
 };
 
@@ -314,6 +428,7 @@ struct Pulse_VCOWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 40.0)), module, Pulse_VCO::PM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 51.5)), module, Pulse_VCO::VM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 63.0)), module, Pulse_VCO::PW_IN_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(17.5, 77.5)), module, Pulse_VCO::SYNC_INPUT));
 
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(18.5, 14.0)), module, Pulse_VCO::OUTPUT_OUTPUT));
 	}
@@ -324,9 +439,13 @@ struct Pulse_VCOWidget : ModuleWidget
 
 		menu->addChild(new MenuSeparator);
 
-		menu->addChild(createIndexPtrSubmenuItem("Band", {"Unlimited", "Limited"}, &module->bandLimited));
-		menu->addChild(createIndexPtrSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "20"},
-												 &module->menu_num_Harmonics));
+		menu->addChild(createIndexPtrSubmenuItem("Band", {"Unlimited", "Limited", "PolyBLEP"}, &module->bandLimited));
+		menu->addChild(createIndexPtrSubmenuItem("Interpolation", {"None", "Linear", "Cubic"}, &module->interpolation));
+		menu->addChild(createIndexSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "20", "Auto"},
+												 [=]()
+												 { return module->menu_num_Harmonics; },
+												 [=](size_t menu_num)
+												 { module->SetNum_Harmonics(menu_num); }));
 	}
 };
 
@@ -1,5 +1,6 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-wavetables.hpp"
 #include <math.h>
 
 struct Sine_VCO : Module
@@ -20,6 +21,7 @@ struct Sine_VCO : Module
 		FM_IN_INPUT,
 		PM_IN_INPUT,
 		VM_IN_INPUT,
+		SYNC_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId
@@ -37,43 +39,65 @@ struct Sine_VCO : Module
 	const float PHASE_MOD_MULTIPLIER = 0.1f;
 	const float VOLUME_MOD_MULTIPLIER = 0.1f;
 
-#define STS_NUM_WAVE_SAMPLES 1000
+	int interpolation = STS_INTERPOLATE_LINEAR;
 
-	// An array of values to represent the sine wave, as values in the range [-1.0, 1.0]. This can arguebly be regarded as a wavetable
-	float sine_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
+	// The sine wave, shared read-only with all other instances. This can arguebly be regarded as a wavetable
+	std::shared_ptr<const STS_Wavetable> sine_wave_lookup_table;
 
 	// local class variable declarations
 	float pitch_param, phase_param, volume_param;
-	float freq = 0.f, pitch = 0.f, phase_shift = 0.f, volume_out = 0.f;
+	float freq = 0.f, pitch = 0.f, volume_out = 0.f;
+	uint32_t phase_shift = 0; // Phase shift in fixed point cycles
 	float freq_mod = 0.f, phase_mod = 0.f, volume_mod = 0.f;
 	float freq_mod_attn = 0.f, phase_mod_attn = 0.f, volume_mod_attn = 0.f;
 	int num_channels, idx;
 
+	// The poly channels are computed 4 at a time
+	simd::float_4 poly_pitch, poly_freq;
+	simd::int32_4 poly_phase;
+
+	// Hard sync of the sample being computed
+	bool sync_edge;
+	float sync_since, sync_jump;
+	uint32_t edge_phase;
+	simd::float_4 poly_sync_edge, poly_sync_since, poly_sync_jump;
+	simd::int32_4 poly_edge_phase;
+
 	// Array of 16 phases to accomodate for polyphony
-	float phase[16] = {};
+	uint32_t phase[16] = {};
+
+	// Hard sync: the last sample of the master and the sample held back for the PolyBLEP, per poly channel
+	float sync_prev[16] = {};
+	float sync_held[16] = {};
+	int sync_Channels = -1; // Channel count they were set for, -1 while the sync input is not patched
 
 	// Maps phase & phase shift to an index in the wave table
-	float STS_My_Sine(float phase, float phase_shift)
+	float STS_My_Sine(uint32_t phase, uint32_t phase_shift)
 	{
 		int index;
+		float frac;
 
-		// Compute the index by mapping phase + phase_shift across the total number of samples in the wave table
-		index = (int)((phase + phase_shift) * STS_NUM_WAVE_SAMPLES);
-		index = index % STS_NUM_WAVE_SAMPLES;
+		// The top bits of the fixed point phase + phase_shift are the index in the wave table
+		index = STS_Wave_Index(phase + phase_shift, &frac);
 
-		return (sine_wave_lookup_table[index]);
+		return (STS_Wave_Sample(sine_wave_lookup_table.get(), index, frac, interpolation));
 	}
 
-	void InitSine_Waves()
+	// The same for 4 poly channels at a time
+	simd::float_4 STS_My_Sine(simd::int32_4 phase, uint32_t phase_shift)
 	{
-		int i;
+		simd::int32_4 index;
+		simd::float_4 frac;
 
-		// Populate the sine wave table
-		// Filled with a full sine cycle, multiplied by 5.0 to reflect the default +/- 5V audio output levels
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
-		{
-			sine_wave_lookup_table[i] = 5.0f * std::sin(M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES));
-		}
+		index = STS_Wave_Index(phase + (int32_t)phase_shift, &frac);
+
+		return (STS_Wave_Sample(sine_wave_lookup_table.get(), index, frac, interpolation));
+	}
+
+	void InitSine_Waves()
+	{
+		// Get the sine wave table from the plugin-wide cache
+		sine_wave_lookup_table = STS_Get_Wavetable(STS_WAVE_SINE);
 	}
 
 	Sine_VCO()
@@ -89,6 +113,7 @@ struct Sine_VCO : Module
 		configInput(FM_IN_INPUT, "Frequency modulation");
 		configInput(PM_IN_INPUT, "Phase modulation");
 		configInput(VM_IN_INPUT, "Volume modulation");
+		configInput(SYNC_INPUT, "Hard sync");
 		configOutput(OUTPUT_OUTPUT, "Audio Out");
 
 		InitSine_Waves();
@@ -114,15 +139,11 @@ struct Sine_VCO : Module
 		else
 			volume_out = volume_param;
 
-		// Compute the phase shift as per the controls. Make sure it is not negative, as this may happen with modulation with a bipolar signal
+		// Compute the phase shift as per the controls, in fixed point. A negative shift, as may happen with modulation with a bipolar signal, wraps around by itself
 		if (getInput(PM_IN_INPUT).isConnected())
-		{
-			phase_shift = phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER;
-			if (phase_shift < 0.0f)
-				phase_shift += 1.0f;
-		}
+			phase_shift = STS_Fixed_Phase(phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER);
 		else
-			phase_shift = phase_param;
+			phase_shift = STS_Fixed_Phase(phase_param);
 
 		// Is the V-In connected?
 		num_channels = getInput(V_OCT_IN_INPUT).getChannels();
@@ -144,44 +165,98 @@ struct Sine_VCO : Module
 			else if (freq > 20000.f)
 				freq = 20000.f;
 
-			// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-			phase[0] += freq * args.sampleTime;
-			if (phase[0] >= 1.f)
-				phase[0] -= 1.f;
+			if (getInput(SYNC_INPUT).isConnected())
+			{
+				// Just patched? Then start from the master and the wave as they are now. An edge against the last level of an earlier patch
+				// would be a false one, and the sample held back a stale one
+				if (sync_Channels != num_channels)
+				{
+					sync_prev[0] = getInput(SYNC_INPUT).getVoltage();
+					sync_held[0] = STS_My_Sine(phase[0], phase_shift);
+				}
+
+				// Accumulate the phase, resetting it at a rising edge of the master, and smooth the jump the reset makes in the wave
+				sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getVoltage(), &sync_prev[0], &sync_since);
+				edge_phase = STS_Sync_Phase(&phase[0], freq * args.sampleTime, sync_edge, sync_since);
+				sync_jump = (sync_edge ? STS_My_Sine(0, phase_shift) - STS_My_Sine(edge_phase, phase_shift) : 0.f);
+				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_Sync_BLEP(STS_My_Sine(phase[0], phase_shift), sync_edge, sync_jump, sync_since, &sync_held[0]));
+			}
+			else
+			{
+				// Accumulate the phase in fixed point, it wraps around by itself at the end of the cycle
+				phase[0] += STS_Fixed_Phase(freq * args.sampleTime);
 
-			// Compute the wave via the wave table,
-			// output to the correct channel, multiplied by the output volume
-			getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Sine(phase[0], phase_shift));
+				// Compute the wave via the wave table,
+				// output to the correct channel, multiplied by the output volume
+				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Sine(phase[0], phase_shift));
+			}
 		}
 		else
 		{
 			// Else, compute it as per the V/Oct input for each poly channel
-			// Loop through all input channels
-			for (idx = 0; idx < num_channels; idx++)
+			// Loop through the input channels, 4 at a time. A last group of less than 4 computes the unused channels too, they are ignored
+			for (idx = 0; idx < num_channels; idx += 4)
 			{
-				pitch = getInput(V_OCT_IN_INPUT).getVoltage(idx);
-				freq = pitch_param * std::pow(2.f, pitch);
+				poly_pitch = getInput(V_OCT_IN_INPUT).getVoltageSimd<simd::float_4>(idx);
+				poly_freq = pitch_param * dsp::approxExp2_taylor5(poly_pitch);
 
 				// Compute the pitch as per the controls
 				if (getInput(FM_IN_INPUT).isConnected())
-					freq = freq + freq * freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER;
+					poly_freq = poly_freq + poly_freq * (freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER);
 
 				// limit the pitch if modulation takes it too extreme
-				if (freq < 10.f)
-					freq = 10.f;
-				else if (freq > 20000.f)
-					freq = 20000.f;
-
-				// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-				phase[idx] += freq * args.sampleTime;
-				if (phase[idx] >= 1.f)
-					phase[idx] -= 1.f;
-
-				// Compute the wave via the wave table,
-				// output to the correct channel, multiplied by the output volume
-				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Sine(phase[idx], phase_shift), idx);
+				poly_freq = simd::clamp(poly_freq, simd::float_4(10.f), simd::float_4(20000.f));
+
+				if (getInput(SYNC_INPUT).isConnected())
+				{
+					// Just patched, or a new channel count? Then start from the master and the waves as they are now, as above
+					if (sync_Channels != num_channels)
+					{
+						getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx).store(&sync_prev[idx]);
+						STS_My_Sine(simd::int32_4::load((int32_t *)&phase[idx]), phase_shift).store(&sync_held[idx]);
+					}
+
+					// The same per channel, a monophonic master syncs all channels
+					poly_sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx), &sync_prev[idx], &poly_sync_since);
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]);
+					poly_edge_phase = STS_Sync_Phase(&poly_phase, poly_freq * args.sampleTime, poly_sync_edge, poly_sync_since);
+					poly_phase.store((int32_t *)&phase[idx]);
+					poly_sync_jump = 0.f;
+					if (simd::movemask(poly_sync_edge))
+						poly_sync_jump = STS_My_Sine(simd::int32_4(0), phase_shift) - STS_My_Sine(poly_edge_phase, phase_shift);
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_Sync_BLEP(STS_My_Sine(poly_phase, phase_shift), poly_sync_edge, poly_sync_jump, poly_sync_since, &sync_held[idx]), idx);
+				}
+				else
+				{
+					// Accumulate the phases in fixed point, they wrap around by themselves at the end of the cycle
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]) + STS_Fixed_Phase(poly_freq * args.sampleTime);
+					poly_phase.store((int32_t *)&phase[idx]);
+
+					// Compute the wave via the wave table,
+					// output to the correct channels, multiplied by the output volume
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_My_Sine(poly_phase, phase_shift), idx);
+				}
 			}
 		}
+
+		sync_Channels = (getInput(SYNC_INPUT).isConnected() ? num_channels : -1);
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+
+		json_object_set_new(rootJ, "Interpolation", json_integer(interpolation));
+
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		json_t *interpolationJ = json_object_get(rootJ, "Interpolation");
+
+		if (interpolationJ)
+			interpolation = json_integer_value(interpolationJ);
 	}
 };
 
@@ -200,7 +275,7 @@ struct Sine_VCOWidget : ModuleWidget
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 29.5)), module, Sine_VCO::FM_ATTN_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 44.5)), module, Sine_VCO::PM_ATTN_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 59.5)), module, Sine_VCO::VM_ATTN_PARAM));
-		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 74.5)), module, Sine_VCO::PITCH_PARAM));
+		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 74.5)), module, Sine_VCO::PITCH_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 89.5)), module, Sine_VCO::PHASE_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 104.5)), module, Sine_VCO::VOLUME_PARAM));
 
@@ -208,9 +283,19 @@ struct Sine_VCOWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 29.5)), module, Sine_VCO::FM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 44.5)), module, Sine_VCO::PM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 59.5)), module, Sine_VCO::VM_IN_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 74.5)), module, Sine_VCO::SYNC_INPUT));
 
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(18.5, 14.0)), module, Sine_VCO::OUTPUT_OUTPUT));
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		Sine_VCO *module = getModule<Sine_VCO>();
+
+		menu->addChild(new MenuSeparator);
+
+		menu->addChild(createIndexPtrSubmenuItem("Interpolation", {"None", "Linear", "Cubic"}, &module->interpolation));
+	}
 };
 
 Model *modelSine_VCO = createModel<Sine_VCO, Sine_VCOWidget>("Sine-VCO");
\ No newline at end of file
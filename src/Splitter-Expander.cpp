@@ -0,0 +1,104 @@
+#include "plugin.hpp"
+#include "sts-base.hpp"
+#include "Splitter.hpp"
+#include <math.h>
+
+struct Splitter_Expander : Module
+{
+	enum ParamId
+	{
+		PARAMS_LEN
+	};
+	enum InputId
+	{
+		INPUTS_LEN
+	};
+	enum OutputId
+	{
+		ENUMS(CH_OUTPUTS, STS_SPL_BANK_OUTPUTS),
+		OUTPUTS_LEN
+	};
+	enum LightId
+	{
+		ENUMS(LGT_LIGHTS, STS_SPL_BANK_OUTPUTS),
+		LIGHTS_LEN
+	};
+
+	// Some class-wide parameters
+	int old_num_Channels = 0, num_Channels, cur_Channel; // Number of active channels on this panel
+
+	Splitter_Expander()
+	{
+		char name[64] = {}; // string to format text
+
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+
+		// Channels numbered on from the outputs on the left
+		for (cur_Channel = 0; cur_Channel < STS_SPL_BANK_OUTPUTS; cur_Channel++)
+		{
+			(void)sprintf(name, "Channel +%d", cur_Channel + 1);
+			configOutput(CH_OUTPUTS + cur_Channel, name);
+		}
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		int bank = 0;								   // Which bank of the Splitter this expander outputs
+		Module *master;								   // The Splitter
+		const STS_Spl_Expander_Message *message = NULL; // Where this expander reads its voltages
+		int first;									   // First channel of the bank
+
+		// Find the Splitter on the left, past the expanders in between. Each of those outputs a bank before this one
+		for (master = leftExpander.module; master && master->model == modelSplitter_Expander; master = master->leftExpander.module)
+			bank++;
+
+		// No Splitter, or too far to the right? Then no channels
+		first = STS_SPL_BANK_OUTPUTS * (1 + bank);
+		num_Channels = 0;
+		if (master && master->model == modelSplitter && bank < STS_SPL_MAX_BANKS)
+		{
+			message = (const STS_Spl_Expander_Message *)master->rightExpander.consumerMessage;
+			num_Channels = clamp(message->num_Channels - first, 0, STS_SPL_BANK_OUTPUTS);
+		}
+
+		// Did the number of channels change? Then switch off the lights and outputs past the new channel count, as the Splitter does
+		if (num_Channels != old_num_Channels)
+		{
+			for (cur_Channel = num_Channels; cur_Channel < STS_SPL_BANK_OUTPUTS; cur_Channel++)
+			{
+				getLight(LGT_LIGHTS + cur_Channel).setBrightness(0.0);
+				getOutput(CH_OUTPUTS + cur_Channel).setVoltage(0.0f);
+			}
+			old_num_Channels = num_Channels;
+		}
+
+		for (cur_Channel = 0; cur_Channel < num_Channels; cur_Channel++)
+		{
+			getOutput(CH_OUTPUTS + cur_Channel).setVoltage(message->volt_Out[first + cur_Channel]);
+			getLight(LGT_LIGHTS + cur_Channel).setBrightness(1.0);
+		}
+	}
+};
+
+struct Splitter_ExpanderWidget : ModuleWidget
+{
+	Splitter_ExpanderWidget(Splitter_Expander *module)
+	{
+		setModule(module);
+		setPanel(createPanel(asset::plugin(pluginInstance, "res/Splitter-Expander.svg")));
+
+		addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+		// Same places as the outputs of the Splitter
+		for (int i = 0; i < STS_SPL_BANK_OUTPUTS; i++)
+		{
+			addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(12.7, 37.586 + 17.f * i)), module, Splitter_Expander::CH_OUTPUTS + i));
+			addChild(createLightCentered<SmallLight<STSRedLight>>(mm2px(Vec(2.959, 37.64 + 17.f * i)), module, Splitter_Expander::LGT_LIGHTS + i));
+		}
+	}
+};
+
+Model *modelSplitter_Expander = createModel<Splitter_Expander, Splitter_ExpanderWidget>("Splitter-Expander");
@@ -1,5 +1,7 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-sort.hpp"
+#include "Splitter.hpp"
 #include <math.h>
 
 struct Splitter : Module
@@ -19,6 +21,7 @@ struct Splitter : Module
 		CH_2_OUT_OUTPUT,
 		CH_3_OUT_OUTPUT,
 		CH_4_OUT_OUTPUT,
+		SORTED_OUT_OUTPUT,
 		OUTPUTS_LEN
 	};
 	enum LightId
@@ -31,10 +34,17 @@ struct Splitter : Module
 	};
 
 	// Some class-wide parameters
-	float volt_In[4], volt_Temp;						 // Input voltage
+	float volt_In[STS_SORT_MAX_CHANNELS];				 // Input voltages, sorted ascending when sorting by pitch
+	float volt_Out[STS_SORT_MAX_CHANNELS];				 // Output voltages, in the order of the menu
 	int splitOrder = 0;									 // Split order menu entry
+#define SPLITORDER_CHANNEL 0
+#define SPLITORDER_PITCH_UP 1
+#define SPLITORDER_PITCH_DOWN 2
 	int old_num_Channels = 0, num_Channels, cur_Channel; // Number of active channels
 
+	// The expanders on the right read the voltages from this double buffer, the engine flips it after each sample
+	STS_Spl_Expander_Message spl_Messages[2] = {};
+
 	Splitter()
 	{
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -43,281 +53,74 @@ struct Splitter : Module
 		configOutput(CH_2_OUT_OUTPUT, "Channel 2");
 		configOutput(CH_3_OUT_OUTPUT, "Channel 3");
 		configOutput(CH_4_OUT_OUTPUT, "Channel 4");
+		configOutput(SORTED_OUT_OUTPUT, "Sorted Polyphonic");
+
+		// The expanders read from these
+		rightExpander.producerMessage = &spl_Messages[0];
+		rightExpander.consumerMessage = &spl_Messages[1];
 	}
 
 	void process(const ProcessArgs &args) override
 	{
+		STS_Spl_Expander_Message *message = (STS_Spl_Expander_Message *)rightExpander.producerMessage;
+		bool expanded = rightExpander.module && rightExpander.module->model == modelSplitter_Expander;
+
 		// Get the number of channels from the Input, if any
 		num_Channels = getInput(POLY_IN_INPUT).getChannels();
 
 		// Did the number of channels change? If so, make sure all lights are out before switching them on as per the new channel count
-		// This to avoid flickering lights for no reason, every time process() is called. Also volt array is set to zero to avoid old voltages to be sent
+		// This to avoid flickering lights for no reason, every time process() is called. Also the outputs are set to zero to avoid old voltages to be sent
 		if (num_Channels != old_num_Channels)
 		{
-			getLight(LGT_1_OUT_LIGHT).setBrightness(0.0);
-			getLight(LGT_2_OUT_LIGHT).setBrightness(0.0);
-			getLight(LGT_3_OUT_LIGHT).setBrightness(0.0);
-			getLight(LGT_4_OUT_LIGHT).setBrightness(0.0);
-			volt_In[0] = volt_In[1] = volt_In[2] = volt_In[3] = 0.0f;
-			old_num_Channels = num_Channels;
-		}
-
-		// Input not connected? Do nothing...
-		if (num_Channels == 0)
-			return;
-
-		// Sort by Channel Number? Then simply go through the channels in channel order
-		// Only one Channel connected? Just copy the single channel, no need to sort
-		if (splitOrder == 0 || num_Channels == 1)
-		{
-			for (cur_Channel = 0; cur_Channel < num_Channels; cur_Channel++)
-			{
-				volt_In[cur_Channel] = getInput(POLY_IN_INPUT).getVoltage(cur_Channel);
-				getOutput(cur_Channel).setVoltage(volt_In[cur_Channel]);
-				getLight(cur_Channel).setBrightness(1.0);
-			}
-			// Done, so return
-			return;
-		}
-
-		// Sort by Pitch up? Then get all voltages, sort them ascending and then output
-		if (splitOrder == 1)
-		{
-			// Optimized code for sorting based on # of channels
-			if (num_Channels == 2)
-			{
-				// Get the input values in the array
-				volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-				volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-
-				// Now sort the two values ascending
-				if (volt_In[0] > volt_In[1])
-				{
-					volt_Temp = volt_In[0];
-					volt_In[0] = volt_In[1];
-					volt_In[1] = volt_Temp;
-				}
-
-				// Output the voltages and set the lights
-				getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-				getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-				getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-				getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-				// Done, so return
-				return;
-			}
-
-			if (num_Channels == 3)
-			{
-				// Get the input values in the array
-				volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-				volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-				volt_In[2] = getInput(POLY_IN_INPUT).getVoltage(2);
-
-				// Now sort the three values ascending, using a simplified bubble sort
-				if (volt_In[0] > volt_In[1])
-				{
-					volt_Temp = volt_In[0];
-					volt_In[0] = volt_In[1];
-					volt_In[1] = volt_Temp;
-				}
-				// Now sort the last two elements. Now the last element is the largest
-				if (volt_In[1] > volt_In[2])
-				{
-					volt_Temp = volt_In[1];
-					volt_In[1] = volt_In[2];
-					volt_In[2] = volt_Temp;
-				}
-				// Now sort the first two elements and we're done
-				if (volt_In[0] > volt_In[1])
-				{
-					volt_Temp = volt_In[0];
-					volt_In[0] = volt_In[1];
-					volt_In[1] = volt_Temp;
-				}
-
-				// Output the voltages and set the lights
-				getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-				getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-				getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-				getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-				getOutput(CH_3_OUT_OUTPUT).setVoltage(volt_In[2]);
-				getLight(LGT_3_OUT_LIGHT).setBrightness(1.0);
-				// Done, so return
-				return;
-			}
-
-			// 4 channels remaining as last option. Get the input values in the array
-			volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-			volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-			volt_In[2] = getInput(POLY_IN_INPUT).getVoltage(2);
-			volt_In[3] = getInput(POLY_IN_INPUT).getVoltage(3);
-
-			// 4 channels, so sort the four values ascending. First sort 0 & 1, then 2 & 3 so we have two sorted mini-arrays of length 2
-			if (volt_In[0] > volt_In[1])
-			{
-				volt_Temp = volt_In[0];
-				volt_In[0] = volt_In[1];
-				volt_In[1] = volt_Temp;
-			}
-			if (volt_In[2] > volt_In[3])
-			{
-				volt_Temp = volt_In[2];
-				volt_In[2] = volt_In[3];
-				volt_In[3] = volt_Temp;
-			}
-			// Now find the smallest of 0 & 2 and swap
-			if (volt_In[0] > volt_In[2])
+			for (cur_Channel = 0; cur_Channel < 4; cur_Channel++)
 			{
-				volt_Temp = volt_In[0];
-				volt_In[0] = volt_In[2];
-				volt_In[2] = volt_Temp;
+				getLight(LGT_1_OUT_LIGHT + cur_Channel).setBrightness(0.0);
+				getOutput(CH_1_OUT_OUTPUT + cur_Channel).setVoltage(0.0f);
 			}
-			// Now find the largest of 1 & 3 and swap
-
-			if (volt_In[1] > volt_In[3])
-			{
-				volt_Temp = volt_In[1];
-				volt_In[1] = volt_In[3];
-				volt_In[3] = volt_Temp;
-			}
-			// Now sort the middle two elements 1 & 2 as they may be out of order yet
-			if (volt_In[1] > volt_In[2])
-			{
-				volt_Temp = volt_In[1];
-				volt_In[1] = volt_In[2];
-				volt_In[2] = volt_Temp;
-			}
-
-			// Output the voltages and set the lights
-			getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-			getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-			getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_3_OUT_OUTPUT).setVoltage(volt_In[2]);
-			getLight(LGT_3_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_4_OUT_OUTPUT).setVoltage(volt_In[3]);
-			getLight(LGT_4_OUT_LIGHT).setBrightness(1.0);
-			// Done, so return
-			return;
+			old_num_Channels = num_Channels;
 		}
 
-		// Splitorder = 2, so sort descending
+		// The sorted output carries as many channels as the input
+		getOutput(SORTED_OUT_OUTPUT).setChannels(num_Channels);
 
-		// Optimized code for sorting based on # of channels
-		if (num_Channels == 2)
+		// Input not connected? Do nothing... but tell the expanders, so they switch off too
+		if (num_Channels == 0)
 		{
-			// Get the input values in the array
-			volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-			volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-
-			// Now sort the two values ascending
-			if (volt_In[0] < volt_In[1])
+			if (expanded)
 			{
-				volt_Temp = volt_In[0];
-				volt_In[0] = volt_In[1];
-				volt_In[1] = volt_Temp;
+				message->num_Channels = 0;
+				rightExpander.requestMessageFlip();
 			}
-
-			// Output the voltages and set the lights
-			getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-			getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-			getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-			// Done, so return
 			return;
 		}
 
-		if (num_Channels == 3)
-		{
-			// Get the input values in the array
-			volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-			volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-			volt_In[2] = getInput(POLY_IN_INPUT).getVoltage(2);
-
-			// Now sort the three values ascending, using a simplified bubble sort
-			if (volt_In[0] < volt_In[1])
-			{
-				volt_Temp = volt_In[0];
-				volt_In[0] = volt_In[1];
-				volt_In[1] = volt_Temp;
-			}
-			// Now sort the last two elements. Now the last element is the largest
-			if (volt_In[1] < volt_In[2])
-			{
-				volt_Temp = volt_In[1];
-				volt_In[1] = volt_In[2];
-				volt_In[2] = volt_Temp;
-			}
-			// Now sort the first two elements and we're done
-			{
-				volt_Temp = volt_In[0];
-				volt_In[0] = volt_In[1];
-				volt_In[1] = volt_Temp;
-			}
-
-			// Output the voltages and set the lights
-			getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-			getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-			getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-			getOutput(CH_3_OUT_OUTPUT).setVoltage(volt_In[2]);
-			getLight(LGT_3_OUT_LIGHT).setBrightness(1.0);
-			// Done, so return
-			return;
-		}
+		// Get all voltages. Sort by Pitch? Then sort them ascending with the sorting network for this many channels, which takes
+		// the same time whatever the voltages. Sort by Channel Number? Then keep them in channel order
+		getInput(POLY_IN_INPUT).readVoltages(volt_In);
+		if (splitOrder != SPLITORDER_CHANNEL)
+			STS_Sort(volt_In, num_Channels);
 
-		// 4 channels remaining as last option. Get the input values in the array
-		volt_In[0] = getInput(POLY_IN_INPUT).getVoltage(0);
-		volt_In[1] = getInput(POLY_IN_INPUT).getVoltage(1);
-		volt_In[2] = getInput(POLY_IN_INPUT).getVoltage(2);
-		volt_In[3] = getInput(POLY_IN_INPUT).getVoltage(3);
+		// Pitch down reads the ascending voltages from the top
+		for (cur_Channel = 0; cur_Channel < num_Channels; cur_Channel++)
+			volt_Out[cur_Channel] = volt_In[splitOrder == SPLITORDER_PITCH_DOWN ? num_Channels - 1 - cur_Channel : cur_Channel];
 
-		// 4 channels, so sort the four values ascending. First sort 0 & 1, then 2 & 3 so we have two sorted mini-arrays of length 2
-		if (volt_In[0] < volt_In[1])
+		// Output the first 4 voltages and set the lights, and all of them on the sorted output
+		for (cur_Channel = 0; cur_Channel < num_Channels && cur_Channel < 4; cur_Channel++)
 		{
-			volt_Temp = volt_In[0];
-			volt_In[0] = volt_In[1];
-			volt_In[1] = volt_Temp;
+			getOutput(CH_1_OUT_OUTPUT + cur_Channel).setVoltage(volt_Out[cur_Channel]);
+			getLight(LGT_1_OUT_LIGHT + cur_Channel).setBrightness(1.0);
 		}
-		if (volt_In[2] < volt_In[3])
-		{
-			volt_Temp = volt_In[2];
-			volt_In[2] = volt_In[3];
-			volt_In[3] = volt_Temp;
-		}
-		// Now find the smallest of 0 & 2 and swap
-		if (volt_In[0] < volt_In[2])
-		{
-			volt_Temp = volt_In[0];
-			volt_In[0] = volt_In[2];
-			volt_In[2] = volt_Temp;
-		}
-		// Now find the largest of 1 & 3 and swap
-		if (volt_In[1] < volt_In[3])
-		{
-			volt_Temp = volt_In[1];
-			volt_In[1] = volt_In[3];
-			volt_In[3] = volt_Temp;
-		}
-		// Now sort the middle two elements 1 & 2 as they may be out of order yet
-		if (volt_In[1] < volt_In[2])
+		if (getOutput(SORTED_OUT_OUTPUT).isConnected())
+			getOutput(SORTED_OUT_OUTPUT).writeVoltages(volt_Out);
+
+		// Hand the voltages past the first 4 to the expanders, if there are any
+		if (expanded)
 		{
-			volt_Temp = volt_In[1];
-			volt_In[1] = volt_In[2];
-			volt_In[2] = volt_Temp;
+			for (cur_Channel = STS_SPL_BANK_OUTPUTS; cur_Channel < num_Channels; cur_Channel++)
+				message->volt_Out[cur_Channel] = volt_Out[cur_Channel];
+			message->num_Channels = num_Channels;
+			rightExpander.requestMessageFlip();
 		}
-
-		// Output the voltages and set the lights
-		getOutput(CH_1_OUT_OUTPUT).setVoltage(volt_In[0]);
-		getLight(LGT_1_OUT_LIGHT).setBrightness(1.0);
-		getOutput(CH_2_OUT_OUTPUT).setVoltage(volt_In[1]);
-		getLight(LGT_2_OUT_LIGHT).setBrightness(1.0);
-		getOutput(CH_3_OUT_OUTPUT).setVoltage(volt_In[2]);
-		getLight(LGT_3_OUT_LIGHT).setBrightness(1.0);
-		getOutput(CH_4_OUT_OUTPUT).setVoltage(volt_In[3]);
-		getLight(LGT_4_OUT_LIGHT).setBrightness(1.0);
-		return;
 	}
 
 	json_t *
@@ -357,6 +160,7 @@ struct SplitterWidget : ModuleWidget
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(12.7, 54.586)), module, Splitter::CH_2_OUT_OUTPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(12.7, 71.586)), module, Splitter::CH_3_OUT_OUTPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(12.7, 88.586)), module, Splitter::CH_4_OUT_OUTPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(12.7, 107.5)), module, Splitter::SORTED_OUT_OUTPUT));
 
 		addChild(createLightCentered<SmallLight<STSRedLight>>(mm2px(Vec(2.959, 37.64)), module, Splitter::LGT_1_OUT_LIGHT));
 		addChild(createLightCentered<SmallLight<STSRedLight>>(mm2px(Vec(2.959, 54.64)), module, Splitter::LGT_2_OUT_LIGHT));
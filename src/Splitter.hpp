@@ -0,0 +1,19 @@
+#pragma once
+
+#include <rack.hpp>
+#include "sts-sort.hpp"
+using namespace rack;
+
+// Splitter expanders: each one placed to the right of a Splitter, or of another expander, adds outputs for the next 4 channels
+// The Splitter sorts all channels once and hands them to the expanders through the expander message double-buffer of the Splitter.
+// Every expander reads that same buffer, so expanders further to the right get the voltages as soon as the first one
+
+#define STS_SPL_BANK_OUTPUTS 4 // Outputs on each panel
+#define STS_SPL_MAX_BANKS 3	   // Expanders taken into account, more to the right are ignored
+
+// The message buffer of the Splitter
+struct STS_Spl_Expander_Message
+{
+	float volt_Out[STS_SORT_MAX_CHANNELS]; // Output voltages, in the order of the menu
+	int num_Channels;					   // Number of active channels, 0 when the input is not connected
+};
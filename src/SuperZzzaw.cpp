@@ -1,14 +1,17 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-wavetables.hpp"
 #include <math.h>
 
 struct SuperZzzaw : Module
 {
 
 // Some constants
-#define STS_NUM_WAVE_SAMPLES 1000
-#define STS_DEF_NUM_HARMONICS 10
+#define STS_HARMONICS_AUTO 20 // Harmonics menu entry filling each octave up to Nyquist
 #define STS_NUM_VCOS 12
+#define STS_NUM_VCO_GROUPS (STS_NUM_VCOS / 4) // The VCO's are computed 4 at a time with SIMD
+#define STS_WAKE_CATCH_UP 0					  // A VCO waking up in poly mode continues at the phase it would have had if it had kept running
+#define STS_WAKE_RESET 1					  // A VCO waking up in poly mode starts at phase 0
 
 	enum ParamId
 	{
@@ -28,6 +31,7 @@ struct SuperZzzaw : Module
 		ENUMS(SZZ_PAN_INPUTS, STS_NUM_VCOS),
 		PITCH_IN_INPUT,
 		V_OCT_IN_INPUT,
+		SYNC_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId
@@ -44,117 +48,198 @@ struct SuperZzzaw : Module
 	// Some class-wide variables
 	int rampDir = 0;
 	int bandLimited = 0;
-	int num_Harmonics = STS_DEF_NUM_HARMONICS;
-	int last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-	int menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-
-	// An array of values to represent the sawtooth wave, as values in the range [-1.0, 1.0]. This can arguebly be regarded as a wavetable
-	// 4 arrays are used: Band-limited (# of harmonics set as per STS_NUM_SAW_HARMONICS) and Band-unlimited, approachng the mathematicsl sawtooth
-	float saw_bl_up_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
-	float saw_bl_down_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
-	float saw_bu_up_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
-	float saw_bu_down_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
+	int interpolation = STS_INTERPOLATE_LINEAR;
+	int wakePhase = STS_WAKE_CATCH_UP;
+	int menu_num_Harmonics = STS_HARMONICS_AUTO; // Only touched by the UI thread, the audio thread gets the tables through saw_bl_waves
+
+	// The sawtooth waves, shared read-only with all other instances. This can arguebly be regarded as a wavetable
+	// 4 kinds of tables are used: Band-limited and Band-unlimited, approachng the mathematicsl sawtooth
+	// The band-limited tables are a mipmap with a table per octave, limited to the # of harmonics set in the Harmonics menu
+	// They are rebuilt on the worker thread by saw_bl_waves, process() picks up the current ones at every sample
+	STS_Wavetable_Loader saw_bl_waves{STS_WAVE_SAW, 0};
+	const STS_Wavetable_Set *saw_bl_wave_lookup_tables = NULL;
+	simd::int32_4 mipmap_level = 0;	  // Mipmap level for the channel being computed, the same in all lanes
+	simd::float_4 mipmap_fade = 0.f; // Crossfade into the next mipmap level
+	std::shared_ptr<const STS_Wavetable> saw_bu_up_wave_lookup_table;
+	std::shared_ptr<const STS_Wavetable> saw_bu_down_wave_lookup_table;
 
 	// local class variable declarations to hold data for each VCO
 	float szz_Level[STS_NUM_VCOS] = {};																	// Level for each VCO
-	float szz_Phase[STS_NUM_VCOS] = {};																	// Phase for each VCO
+	uint32_t szz_Phase[STS_NUM_VCOS] = {};																// Phase for each VCO
 	float szz_Detune[STS_NUM_VCOS] = {};																// Detune for each VCO
 	float szz_Pan[STS_NUM_VCOS] = {};																	// Pan for each VCO
-	float mono_Phase[STS_NUM_VCOS] = {};																// Phase per VCO in case of monophonic (disconnected VCO_IN)
-	float szz_Out[2][STS_NUM_VCOS] = {};																// Stereo output for each VCO for each channel
+	uint32_t mono_Phase[STS_NUM_VCOS] = {};																// Phase per VCO in case of monophonic (disconnected VCO_IN)
+	float szz_Detune_Mult[STS_NUM_VCOS] = {};															// Frequency multiplier for each VCO, 1 + detune
+	float szz_Gain[2][STS_NUM_VCOS] = {};																// Left and right gain for each VCO, level and pan combined
+	bool szz_Group_Active[STS_NUM_VCO_GROUPS] = {};														// Any of the 4 VCO's in the group has a level != 0.0
+	bool szz_Awake[STS_NUM_VCOS] = {};																	// Level != 0.0 at the previous sample
 	int mapped_Harmonics[20] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 14, 16, 18, 20, 25, 30, 35, 40, 50}; // Mapping harmonics menu number to value
 
 	bool szz_Stereo = false;
 
 	// Array of 16 phases to accomodate for polyphony, one for each VCO, as each VCO has a detune/phase that needs to be administered separately
-	float channel_phase[16][STS_NUM_VCOS] = {};
-
-	// Maps phase & phase shift to an index in the wave table
-	float STS_My_Saw(float phase, float phase_shift)
+	// The VCO's of a channel are next to each other, so they load as groups of 4
+	uint32_t channel_phase[16][STS_NUM_VCOS] = {};
+	float channel_freq[16] = {};			  // Frequency of each channel, before detune
+	int32_t channel_mipmap_level[16] = {};	  // Mipmap level and crossfade of each channel
+	float channel_mipmap_fade[16] = {};
+
+	// VCO's with a level of 0.0 sleep: their phase is not accumulated. To pick up where it would have been, each channel counts the cycles of its
+	// undetuned frequency in 32.32 fixed point, which wraps only after 2^32 cycles. A VCO going to sleep remembers the count,
+	// waking up it moves on by the cycles since, times its detune
+	uint64_t channel_cycles[16] = {};
+	uint64_t sleep_cycles[16][STS_NUM_VCOS] = {};
+
+	// Hard sync resets all VCO's of a channel at once: the last sample of the master, and the left and right samples held back for the PolyBLEP
+	float sync_prev[16] = {};
+	float sync_held[2][16] = {};
+	int sync_Channels = -1; // Channel count they were set for, -1 while the sync input is not patched
+
+	// Maps the phases & phase shifts of 4 VCO's to indices in the wave table
+	simd::float_4 STS_My_Saw(simd::int32_4 phase, simd::int32_4 phase_shift)
 	{
-		int index;
+		simd::int32_4 index;
+		simd::float_4 frac;
 
-		// Compute the index by mapping phase + phase_shift across the total number of samples in the wave table
-		index = (int)((phase + phase_shift) * STS_NUM_WAVE_SAMPLES);
-		index = index % STS_NUM_WAVE_SAMPLES;
+		// The top bits of the fixed point phase + phase_shift are the index in the wave table
+		index = STS_Wave_Index(phase + phase_shift, &frac);
 
 		// ramp is up?
 		if (rampDir == 0)
 		{
 			// Band-unlimited?
 			if (bandLimited)
-				return (saw_bl_up_wave_lookup_table[index]);
+				return (STS_Mipmap_Sample(saw_bl_wave_lookup_tables->up, mipmap_level, mipmap_fade, index, frac, interpolation));
 			else
-				return (saw_bu_up_wave_lookup_table[index]);
+				return (STS_Wave_Sample(saw_bu_up_wave_lookup_table.get(), index, frac, interpolation));
 		}
 		else // ramp is down
 		{
 			// Band-unlimited?
 			if (bandLimited)
-				return (saw_bl_down_wave_lookup_table[index]);
+				return (STS_Mipmap_Sample(saw_bl_wave_lookup_tables->down, mipmap_level, mipmap_fade, index, frac, interpolation));
 			else
-				return (saw_bu_down_wave_lookup_table[index]);
+				return (STS_Wave_Sample(saw_bu_down_wave_lookup_table.get(), index, frac, interpolation));
 		}
 	}
 
-	// Custom OnReset() to initialize wave tables and set some default values
-	void onReset() override
-	{
-		rampDir = 0;
-		bandLimited = 0;
-		num_Harmonics = STS_DEF_NUM_HARMONICS;
-		menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		InitSaw_Waves(num_Harmonics);
-	}
-
-	void InitSaw_Waves(int num_Harm)
+	// Computes all VCO's of one channel, 4 at a time, and adds them into the stereo output
+	// VCO's with a level of 0.0 do not contribute and sleep: their phase stays where it is
+	// At a sync edge all VCO's reset at the fraction since of the sample, the jumps they make add up into the jumps of the outputs
+	void STS_Szz_Channel(uint32_t *phases, float freq, float sampleTime, bool sync_edge, float sync_since,
+						 float *left_Out, float *right_Out, float *left_Jump, float *right_Jump)
 	{
-		int i, j;
-		float iter, harmonic, h_factor, max_harmonic;
-
-		// Populate the band-unlimited sawtooth wave tables
-		// Filled with a full sawtooth cycle, multiplied by 5.0 to reflect the default +/- 5V audio output levels
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
-		{
-			// Up ramp
-			saw_bu_up_wave_lookup_table[i] = -5.0f + 10.0f * ((float)i / STS_NUM_WAVE_SAMPLES);
-			// Down ramp
-			saw_bu_down_wave_lookup_table[STS_NUM_WAVE_SAMPLES - i - 1] = saw_bu_up_wave_lookup_table[i];
-		}
+		simd::float_4 left = 0.f, right = 0.f, left_jump = 0.f, right_jump = 0.f, saw_wave, inc;
+		simd::int32_4 phase, step, shift, edge_phase;
+		int i;
 
-		// Using harmonic sine waves to mimic a band-limited sawtooth wave to limit aliases
-		// Sawtooth = all harmonics 2nd 3rd 4th &c. where 2nd = ½, 3rd = ¹/₃ & 4th = ¼ volume.
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		for (i = 0; i < STS_NUM_VCOS; i += 4)
 		{
-			iter = M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES);
-			saw_bl_down_wave_lookup_table[i] = 0.0f;
+			if (!szz_Group_Active[i / 4])
+				continue;
 
-			// Now loop through the harmonics until...
-			for (j = 1; j <= num_Harm; j++)
+			shift = simd::int32_4::load((int32_t *)&szz_Phase[i]);
+			if (sync_edge)
 			{
-				h_factor = (float)j;
-				harmonic = std::sin(h_factor * iter) / h_factor;
-				saw_bl_down_wave_lookup_table[i] = saw_bl_down_wave_lookup_table[i] + harmonic;
+				// Reset the phases, the sleeping VCO's too
+				inc = freq * sampleTime * simd::float_4::load(&szz_Detune_Mult[i]);
+				inc = inc & (simd::float_4::load(&szz_Level[i]) != 0.f);
+				phase = simd::int32_4::load((int32_t *)&phases[i]);
+				edge_phase = STS_Sync_Phase(&phase, inc, simd::float_4::mask(), simd::float_4(sync_since));
+				saw_wave = STS_My_Saw(simd::int32_4(0), shift) - STS_My_Saw(edge_phase, shift);
+				left_jump += saw_wave * simd::float_4::load(&szz_Gain[0][i]);
+				right_jump += saw_wave * simd::float_4::load(&szz_Gain[1][i]);
 			}
+			else
+			{
+				// Accumulate the phases in fixed point, they wrap around by themselves at the end of the cycle
+				step = STS_Fixed_Phase(freq * sampleTime * simd::float_4::load(&szz_Detune_Mult[i]));
+				step = step & simd::int32_4::cast(simd::float_4::load(&szz_Level[i]) != 0.f);
+				phase = simd::int32_4::load((int32_t *)&phases[i]) + step;
+			}
+			phase.store((int32_t *)&phases[i]);
+
+			// Silent VCO's have a gain of 0.0
+			saw_wave = STS_My_Saw(phase, shift);
+			left += saw_wave * simd::float_4::load(&szz_Gain[0][i]);
+			right += saw_wave * simd::float_4::load(&szz_Gain[1][i]);
 		}
 
-		// Now fnd the max harmonic value to correct the output voltage between -5.0 and 5.0 V
-		// Find tha largest harmoic first
-		max_harmonic = 0.0f;
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		*left_Out = left[0] + left[1] + left[2] + left[3];
+		*right_Out = right[0] + right[1] + right[2] + right[3];
+		*left_Jump = left_jump[0] + left_jump[1] + left_jump[2] + left_jump[3];
+		*right_Jump = right_jump[0] + right_jump[1] + right_jump[2] + right_jump[3];
+	}
+
+	// At a sync edge the sleeping VCO's of a channel reset too, also those of groups that are skipped. Their phase is 0 at the edge,
+	// and waking up they catch up from the cycles counted at the edge. Without sleep, as in monophonic mode, they only reset
+	void STS_Szz_Sync_Sleeping(uint32_t *phases, uint64_t *sleep, uint64_t edge_cycles)
+	{
+		for (int i = 0; i < STS_NUM_VCOS; i++)
 		{
-			if (saw_bl_down_wave_lookup_table[i] > max_harmonic)
-				max_harmonic = saw_bl_down_wave_lookup_table[i];
+			if (szz_Awake[i])
+				continue;
+			phases[i] = 0;
+			if (sleep)
+				sleep[i] = edge_cycles;
 		}
-		// Then correct amplitude and make the inverse saw too
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+	}
+
+	// Puts VCO i of all poly channels to sleep, or wakes it up as per the Wake-up Phase menu
+	// The catch-up assumes the detune did not change during the sleep
+	void STS_Szz_Sleep(int i, bool awake)
+	{
+		int channel;
+		double cycles;
+
+		for (channel = 0; channel < 16; channel++)
 		{
-			saw_bl_down_wave_lookup_table[i] *= (5.0f / max_harmonic);
-			saw_bl_up_wave_lookup_table[STS_NUM_WAVE_SAMPLES - i - 1] = saw_bl_down_wave_lookup_table[i];
+			if (!awake)
+				sleep_cycles[channel][i] = channel_cycles[channel];
+			else if (wakePhase == STS_WAKE_RESET)
+				channel_phase[channel][i] = 0;
+			else
+			{
+				cycles = (double)(channel_cycles[channel] - sleep_cycles[channel][i]) * (1.0 / 4294967296.0) * szz_Detune_Mult[i];
+				channel_phase[channel][i] += (uint32_t)(int64_t)((cycles - std::floor(cycles)) * 4294967296.0);
+			}
 		}
 	}
 
+	// Custom OnReset() to initialize wave tables and set some default values
+	void onReset() override
+	{
+		rampDir = 0;
+		bandLimited = 0;
+		interpolation = STS_INTERPOLATE_LINEAR;
+		wakePhase = STS_WAKE_CATCH_UP;
+		SetNum_Harmonics(STS_HARMONICS_AUTO);
+	}
+
+	void InitSaw_Waves()
+	{
+		// Get the band-unlimited sawtooth wave tables from the plugin-wide cache
+		saw_bu_up_wave_lookup_table = STS_Get_Wavetable(STS_WAVE_SAW, 0, STS_RAMP_UP);
+		saw_bu_down_wave_lookup_table = STS_Get_Wavetable(STS_WAVE_SAW, 0, STS_RAMP_DOWN);
+	}
+
+	// Called from the UI thread when the Harmonics menu changes. The band-limited tables are rebuilt on the worker thread,
+	// the audio thread keeps playing the current tables until the new ones are ready
+	void SetNum_Harmonics(int menu_num)
+	{
+		menu_num_Harmonics = clamp(menu_num, 0, STS_HARMONICS_AUTO);
+		if (menu_num_Harmonics == STS_HARMONICS_AUTO)
+			saw_bl_waves.SetMax_Harmonics(0);
+		else
+			saw_bl_waves.SetMax_Harmonics(mapped_Harmonics[menu_num_Harmonics]);
+	}
+
+	// The mipmap levels depend on Nyquist, so rebuild them for the new sample rate
+	void onSampleRateChange(const SampleRateChangeEvent &e) override
+	{
+		saw_bl_waves.SetSample_Rate(e.sampleRate);
+	}
+
 	SuperZzzaw()
 	{
 		int i = 0;		 // index for harmonics loops
@@ -204,37 +289,46 @@ struct SuperZzzaw : Module
 		configParam(PITCH_PARAM, 10.f, 20000.f, dsp::FREQ_C4, "Fixed pitch", " Hz");
 		configInput(V_OCT_IN_INPUT, "Pitch (V//Oct)");
 		configInput(PITCH_IN_INPUT, "Pitch Modulation");
+		configInput(SYNC_INPUT, "Hard sync");
 		configParam(LVL_OUT_PARAM, 0.f, 1.f, 0.5f, "Ouput Level");
 		configOutput(LEFT_OUT_OUTPUT, "Left/Mono Audio Out");
 		configOutput(RIGHT_OUT_OUTPUT, "Right Audio Out");
 
-		InitSaw_Waves(STS_DEF_NUM_HARMONICS);
+		InitSaw_Waves();
 	}
 
 	void process(const ProcessArgs &args) override
 	{
 		int i = 0, channel = 0, num_channels = 0; // used to loop through harmonics & polyphonic channels
-		float left_Out, right_Out;				  // temp output for looping through VCO's
+		float left_Out, right_Out;				  // output of all VCO's of a channel
+		float left_Jump, right_Jump;			  // jump of the outputs at a sync edge
+		bool sync_edge = false;					  // hard sync of the channel being computed
+		float sync_since = 0.f;
 		float pitch_param = 0.f;				  // Pitch parameter
 		float level_param = 0.f;				  // Level Out parameter
-		float chan_voltage = 0.f;				  // Input voltage for the channel
 		float freq = 0.f;						  // Frequency
 		float pan = 0.f;						  // temp pan value
-		float saw_wave = 0.f;					  // temp saw wave value
+		float max_detune = 0.f;					  // Largest detune of all VCO's, to select band-limited tables that do not alias for any of them
+		int level = 0;							  // Mipmap level & crossfade in case of monophonic
+		float fade = 0.f;
+		simd::float_4 poly_freq, poly_fade;		  // Frequencies & mipmap selection for 4 poly channels
+		simd::int32_4 poly_level;
 
-		// Check if we need to recompute the wave tables
-		if (last_menu_num_Harmonics != menu_num_Harmonics)
-		{
-			num_Harmonics = mapped_Harmonics[menu_num_Harmonics];
-			InitSaw_Waves(num_Harmonics);
-			last_menu_num_Harmonics = menu_num_Harmonics;
-		}
+		// Pick up the band-limited tables, swapping in new ones if the worker thread has finished them
+		saw_bl_wave_lookup_tables = &saw_bl_waves.Get();
 
 		// Get all the values from thebasic module UI
 		level_param = getParam(LVL_OUT_PARAM).getValue();
 		pitch_param = getParam(PITCH_PARAM).getValue();
 
-		// Recompute array values
+		// Is only left Out connected? Then mono, else assume stereo
+		// Right-only connected results in mono, but then no sound, as left is the mono channel
+		if (getOutput(LEFT_OUT_OUTPUT).isConnected() && getOutput(RIGHT_OUT_OUTPUT).isConnected())
+			szz_Stereo = true;
+		else
+			szz_Stereo = false;
+
+		// Recompute array values, once per sample for all channels
 		for (i = 0; i < STS_NUM_VCOS; i++)
 		{
 			// Compute the level modulation as per the controls.
@@ -245,22 +339,51 @@ struct SuperZzzaw : Module
 
 			// Compute the phase shift modulation as per the controls.
 			if (getInput(SZZ_PHASE_INPUTS + i).isConnected())
-				szz_Phase[i] = abs(0.1f * getInput(SZZ_PHASE_INPUTS + i).getVoltage()) + getParam(SZZ_PHASE_PARAMS + i).getValue();
+				szz_Phase[i] = STS_Fixed_Phase(abs(0.1f * getInput(SZZ_PHASE_INPUTS + i).getVoltage()) + getParam(SZZ_PHASE_PARAMS + i).getValue());
 			else
-				szz_Phase[i] = getParam(SZZ_PHASE_PARAMS + i).getValue();
+				szz_Phase[i] = STS_Fixed_Phase(getParam(SZZ_PHASE_PARAMS + i).getValue());
 
 			// Compute the detune as per the controls.
 			if (getInput(SZZ_DETUNE_INPUTS + i).isConnected())
 				szz_Detune[i] = 0.01f * getInput(SZZ_DETUNE_INPUTS + i).getVoltage();
 			else
 				szz_Detune[i] = 0.01f * getParam(SZZ_DETUNE_PARAMS + i).getValue();
+			if (std::fabs(szz_Detune[i]) > max_detune)
+				max_detune = std::fabs(szz_Detune[i]);
+			szz_Detune_Mult[i] = 1.f + szz_Detune[i];
 
 			// Compute the panning as per the controls.
 			if (getInput(SZZ_PAN_INPUTS + i).isConnected())
 				szz_Pan[i] = 0.1f * getInput(SZZ_PAN_INPUTS + i).getVoltage();
 			else
 				szz_Pan[i] = getParam(SZZ_PAN_PARAMS + i).getValue();
+
+			// Combine level and panning into the gains. Mono is left + right on the left output
+			if (szz_Stereo)
+			{
+				// Map panning to 0..1
+				pan = (1.f + szz_Pan[i]) * 0.5f;
+				szz_Gain[0][i] = level_param * szz_Level[i] * (1.f - pan);
+				szz_Gain[1][i] = level_param * szz_Level[i] * pan;
+			}
+			else
+			{
+				szz_Gain[0][i] = 2.f * level_param * szz_Level[i];
+				szz_Gain[1][i] = 0.f;
+			}
+		}
+
+		// Only VCO's with a level != 0.0 contribute, the others sleep
+		for (i = 0; i < STS_NUM_VCOS; i++)
+		{
+			if ((szz_Level[i] != 0.f) != szz_Awake[i])
+			{
+				szz_Awake[i] = !szz_Awake[i];
+				STS_Szz_Sleep(i, szz_Awake[i]);
+			}
 		}
+		for (i = 0; i < STS_NUM_VCO_GROUPS; i++)
+			szz_Group_Active[i] = szz_Awake[4 * i] || szz_Awake[4 * i + 1] || szz_Awake[4 * i + 2] || szz_Awake[4 * i + 3];
 
 		// Is the V-In connected?
 		num_channels = getInput(V_OCT_IN_INPUT).getChannels();
@@ -269,15 +392,7 @@ struct SuperZzzaw : Module
 		getOutput(LEFT_OUT_OUTPUT).setChannels(num_channels);
 		getOutput(RIGHT_OUT_OUTPUT).setChannels(num_channels);
 
-		// Is only left Out connected? Then mono, else assume stereo
-		// Right-only connected results in mono, but then no sound, as left is the mono channel
-		if (getOutput(LEFT_OUT_OUTPUT).isConnected() && getOutput(RIGHT_OUT_OUTPUT).isConnected())
-			szz_Stereo = true;
-		else
-			szz_Stereo = false;
-
 		// If no VC-In, use the fixed pitch parameter for each VCO
-		// Use szz_OutP[][][0] for storing the intermediate VCO wave values
 		if (num_channels == 0)
 		{
 			if (getInput(PITCH_IN_INPUT).isConnected())
@@ -291,125 +406,94 @@ struct SuperZzzaw : Module
 			else if (freq > 20000.f)
 				freq = 20000.f;
 
-			// Loop through all VCO's
-			for (i = 0; i < STS_NUM_VCOS; i++)
+			// Select the band-limited tables for the highest detuned frequency
+			STS_Mipmap_Level(freq + freq * max_detune, &level, &fade);
+			mipmap_level = level;
+			mipmap_fade = fade;
+
+			// Reset all VCO's at a rising edge of the master, and smooth the jumps the reset makes in the outputs
+			if (getInput(SYNC_INPUT).isConnected())
 			{
-				// Process only if level != 0.0, as only then it contributes
-				if (szz_Level[i] != 0.f)
+				// Just patched? Then start from the master and the outputs as they are now. An edge against the last level of an earlier patch
+				// would be a false one, and the samples held back stale ones. At a frequency of 0 the phases stay where they are
+				if (sync_Channels != num_channels)
 				{
-					// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-					mono_Phase[i] += (freq + freq * szz_Detune[i]) * args.sampleTime;
-					if (mono_Phase[i] >= 1.f)
-						mono_Phase[i] -= 1.f;
-
-					// Now compute the output
-					if (szz_Stereo)
-					{
-						float pan = 0.f, saw_wave = 0.f;
-
-						// Map panning to 0..1
-						pan = (1.f + szz_Pan[i]) * 0.5f;
-						saw_wave = level_param * szz_Level[i] * STS_My_Saw(mono_Phase[i], szz_Phase[i]);
-						szz_Out[0][i] = (1.0 - pan) * saw_wave;
-						szz_Out[1][i] = pan * saw_wave;
-					}
-					else
-						szz_Out[0][i] = szz_Out[1][i] = level_param * szz_Level[i] * STS_My_Saw(mono_Phase[i], szz_Phase[i]);
+					sync_prev[0] = getInput(SYNC_INPUT).getVoltage();
+					STS_Szz_Channel(mono_Phase, 0.f, args.sampleTime, false, 0.f, &sync_held[0][0], &sync_held[1][0], &left_Jump, &right_Jump);
 				}
-				// If Level = 0.0, make sure this VCO does not contribute
-				else
-					szz_Out[0][i] = szz_Out[1][i] = 0.f;
+				sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getVoltage(), &sync_prev[0], &sync_since);
 			}
 
-			left_Out = right_Out = 0.f;
-			for (i = 0; i < STS_NUM_VCOS; i++)
+			// Compute all VCO's, only the ones with a level != 0.0 advance their phase
+			STS_Szz_Channel(mono_Phase, freq, args.sampleTime, sync_edge, sync_since, &left_Out, &right_Out, &left_Jump, &right_Jump);
+			if (sync_edge)
+				STS_Szz_Sync_Sleeping(mono_Phase, NULL, 0);
+			if (getInput(SYNC_INPUT).isConnected())
 			{
-				left_Out += szz_Out[0][i];
-				right_Out += szz_Out[1][i];
+				left_Out = STS_Sync_BLEP(left_Out, sync_edge, left_Jump, sync_since, &sync_held[0][0]);
+				right_Out = STS_Sync_BLEP(right_Out, sync_edge, right_Jump, sync_since, &sync_held[1][0]);
 			}
 
-			// Compute the wave via the wave table,
-			// output to the correct channel, multiplied by the output volume
-			if (szz_Stereo)
-			{
-				getOutput(LEFT_OUT_OUTPUT).setVoltage(left_Out);
-				getOutput(RIGHT_OUT_OUTPUT).setVoltage(right_Out);
-			}
-			else
-			{
-				getOutput(LEFT_OUT_OUTPUT).setVoltage(left_Out + right_Out);
-				getOutput(RIGHT_OUT_OUTPUT).setVoltage(0);
-			}
+			// Output to the correct channel, the output volume is in the gains
+			getOutput(LEFT_OUT_OUTPUT).setVoltage(left_Out);
+			getOutput(RIGHT_OUT_OUTPUT).setVoltage(right_Out);
 		}
 		else
 		{
 			// Else, compute it as per the V/Oct input for each poly channel
-			// Loop through each poly channel
-			for (channel = 0; channel < num_channels; channel++)
+			// First the pitch for 4 channels at a time, a last group of less than 4 computes the unused channels too
+			for (channel = 0; channel < num_channels; channel += 4)
 			{
-				chan_voltage = getInput(V_OCT_IN_INPUT).getVoltage(channel);
-				freq = pitch_param * std::pow(2.f, chan_voltage);
+				poly_freq = pitch_param * dsp::approxExp2_taylor5(getInput(V_OCT_IN_INPUT).getVoltageSimd<simd::float_4>(channel));
 
 				// Compute the pitch as per the controls
 				if (getInput(PITCH_IN_INPUT).isConnected())
 					// Future
-					freq = freq + freq * getInput(PITCH_IN_INPUT).getVoltage();
+					poly_freq = poly_freq + poly_freq * getInput(PITCH_IN_INPUT).getVoltage();
 
 				// limit the pitch if modulation takes it too extreme
-				if (freq < 10.f)
-					freq = 10.f;
-				else if (freq > 20000.f)
-					freq = 20000.f;
+				poly_freq = simd::clamp(poly_freq, simd::float_4(10.f), simd::float_4(20000.f));
+				poly_freq.store(&channel_freq[channel]);
 
-				// Loop through all VCO's
-				for (i = 0; i < STS_NUM_VCOS; i++)
+				// Select the band-limited tables for the highest detuned frequency
+				STS_Mipmap_Level(poly_freq + poly_freq * max_detune, &poly_level, &poly_fade);
+				poly_level.store(&channel_mipmap_level[channel]);
+				poly_fade.store(&channel_mipmap_fade[channel]);
+			}
+
+			// Then the VCO's of each channel
+			for (channel = 0; channel < num_channels; channel++)
+			{
+				mipmap_level = channel_mipmap_level[channel];
+				mipmap_fade = channel_mipmap_fade[channel];
+
+				// Count the cycles for VCO's waking up, then compute the VCO's that are awake
+				channel_cycles[channel] += STS_Fixed_Phase(channel_freq[channel] * args.sampleTime);
+				if (getInput(SYNC_INPUT).isConnected())
 				{
-					// Accumulate the phase for this VCO, make sure it rotates between 0.0 and 1.0
-					// Note that you have to do this, even if the VCO has no contrubution at this point
-					channel_phase[channel][i] += (freq + freq * szz_Detune[i]) * args.sampleTime;
-					if (channel_phase[channel][i] >= 1.f)
-						channel_phase[channel][i] -= 1.f;
-
-					// If this VCO has a level != 0.0, then process it, else ignore
-					if (szz_Level[i] != 0.f)
+					// Just patched, or a new channel count? Then start from the master and the outputs as they are now, as above
+					if (sync_Channels != num_channels)
 					{
-						// Compute the combined output for the channel
-						saw_wave = level_param * szz_Level[i] * STS_My_Saw(channel_phase[channel][i], szz_Phase[i]);
-						if (szz_Stereo)
-						{
-							// Map panning to 0..1
-							pan = (1.f + szz_Pan[i]) * 0.5f;
-							szz_Out[0][i] = (1.0 - pan) * saw_wave;
-							szz_Out[1][i] = pan * saw_wave;
-						}
-						else
-							szz_Out[0][i] = szz_Out[1][i] = saw_wave;
+						sync_prev[channel] = getInput(SYNC_INPUT).getPolyVoltage(channel);
+						STS_Szz_Channel(channel_phase[channel], 0.f, args.sampleTime, false, 0.f, &sync_held[0][channel], &sync_held[1][channel], &left_Jump, &right_Jump);
 					}
-					else
-						// Set out to zero as starting point for this VCO
-						szz_Out[0][i] = szz_Out[1][i] = 0.f;
+					sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getPolyVoltage(channel), &sync_prev[channel], &sync_since);
 				}
-
-				// Now compute the total output for the channel
-				left_Out = right_Out = 0.f;
-				for (i = 0; i < STS_NUM_VCOS; i++)
+				STS_Szz_Channel(channel_phase[channel], channel_freq[channel], args.sampleTime, sync_edge, sync_since, &left_Out, &right_Out, &left_Jump, &right_Jump);
+				if (sync_edge)
+					STS_Szz_Sync_Sleeping(channel_phase[channel], sleep_cycles[channel], channel_cycles[channel] - STS_Fixed_Phase(sync_since * channel_freq[channel] * args.sampleTime));
+				if (getInput(SYNC_INPUT).isConnected())
 				{
-					left_Out += szz_Out[0][i];
-					right_Out += szz_Out[1][i];
+					left_Out = STS_Sync_BLEP(left_Out, sync_edge, left_Jump, sync_since, &sync_held[0][channel]);
+					right_Out = STS_Sync_BLEP(right_Out, sync_edge, right_Jump, sync_since, &sync_held[1][channel]);
 				}
 
-				if (szz_Stereo)
-				{
-					getOutput(LEFT_OUT_OUTPUT).setVoltage(left_Out, channel);
-					getOutput(RIGHT_OUT_OUTPUT).setVoltage(right_Out, channel);
-				}
-				else
-				{
-					getOutput(LEFT_OUT_OUTPUT).setVoltage((left_Out + right_Out), channel);
-					getOutput(RIGHT_OUT_OUTPUT).setVoltage(0.f, channel);
-				}
+				getOutput(LEFT_OUT_OUTPUT).setVoltage(left_Out, channel);
+				getOutput(RIGHT_OUT_OUTPUT).setVoltage(right_Out, channel);
 			}
 		}
+
+		sync_Channels = (getInput(SYNC_INPUT).isConnected() ? num_channels : -1);
 	}
 
 	json_t *
@@ -418,8 +502,10 @@ struct SuperZzzaw : Module
 		json_t *rootJ = json_object();
 
 		json_object_set_new(rootJ, "Band", json_integer(bandLimited));
+		json_object_set_new(rootJ, "Interpolation", json_integer(interpolation));
 		json_object_set_new(rootJ, "Ramp", json_integer(rampDir));
 		json_object_set_new(rootJ, "Harmonics", json_integer(menu_num_Harmonics));
+		json_object_set_new(rootJ, "Wake-up Phase", json_integer(wakePhase));
 
 		return rootJ;
 	}
@@ -427,15 +513,21 @@ struct SuperZzzaw : Module
 	void dataFromJson(json_t *rootJ) override
 	{
 		json_t *bandLimitedJ = json_object_get(rootJ, "Band");
+		json_t *interpolationJ = json_object_get(rootJ, "Interpolation");
 		json_t *rampDirJ = json_object_get(rootJ, "Ramp");
 		json_t *harmonicsJ = json_object_get(rootJ, "Harmonics");
+		json_t *wakePhaseJ = json_object_get(rootJ, "Wake-up Phase");
 
 		if (bandLimitedJ)
 			bandLimited = json_integer_value(bandLimitedJ);
+		if (interpolationJ)
+			interpolation = json_integer_value(interpolationJ);
 		if (rampDirJ)
 			rampDir = json_integer_value(rampDirJ);
 		if (harmonicsJ)
-			menu_num_Harmonics = json_integer_value(harmonicsJ);
+			SetNum_Harmonics(json_integer_value(harmonicsJ));
+		if (wakePhaseJ)
+			wakePhase = json_integer_value(wakePhaseJ);
 	}
 };
 
@@ -575,6 +667,7 @@ struct SuperZzzawWidget : ModuleWidget
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(79.0, 110.0)), module, SuperZzzaw::PITCH_PARAM));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(89.0, 110.0)), module, SuperZzzaw::PITCH_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(99.0, 110.0)), module, SuperZzzaw::V_OCT_IN_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(65.0, 110.0)), module, SuperZzzaw::SYNC_INPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(109.5, 110.0)), module, SuperZzzaw::LEFT_OUT_OUTPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(117.5, 110.0)), module, SuperZzzaw::RIGHT_OUT_OUTPUT));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(128.0, 110.0)), module, SuperZzzaw::LVL_OUT_PARAM));
@@ -589,8 +682,13 @@ struct SuperZzzawWidget : ModuleWidget
 
 		menu->addChild(createIndexPtrSubmenuItem("Ramp", {"Up", "Down"}, &module->rampDir));
 		menu->addChild(createIndexPtrSubmenuItem("Band", {"Unlimited", "Limited"}, &module->bandLimited));
-		menu->addChild(createIndexPtrSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "12", "14", "16", "18", "20", "25", "30", "35", "40", "50"},
-												 &module->menu_num_Harmonics));
+		menu->addChild(createIndexPtrSubmenuItem("Interpolation", {"None", "Linear", "Cubic"}, &module->interpolation));
+		menu->addChild(createIndexSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "12", "14", "16", "18", "20", "25", "30", "35", "40", "50", "Auto"},
+												 [=]()
+												 { return module->menu_num_Harmonics; },
+												 [=](size_t menu_num)
+												 { module->SetNum_Harmonics(menu_num); }));
+		menu->addChild(createIndexPtrSubmenuItem("Wake-up Phase", {"Catch up", "Reset"}, &module->wakePhase));
 	}
 };
 
@@ -1,5 +1,6 @@
 #include "plugin.hpp"
 #include "sts-base.hpp"
+#include "sts-wavetables.hpp"
 #include <math.h>
 
 struct Triangle_VCO : Module
@@ -20,6 +21,7 @@ struct Triangle_VCO : Module
 		FM_IN_INPUT,
 		PM_IN_INPUT,
 		VM_IN_INPUT,
+		SYNC_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId
@@ -37,107 +39,129 @@ struct Triangle_VCO : Module
 	const float PHASE_MOD_MULTIPLIER = 0.1f;
 	const float VOLUME_MOD_MULTIPLIER = 0.1f;
 
-#define STS_NUM_WAVE_SAMPLES 1000
-#define STS_DEF_NUM_HARMONICS 10
+#define STS_HARMONICS_AUTO 20 // Harmonics menu entry filling each octave up to Nyquist
 
 	// Some class-wide variables
 	int bandLimited = 0;
-	int num_Harmonics = STS_DEF_NUM_HARMONICS;
-	int last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-	int menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-
-	// An array of values to represent the Triangle wave, as values in the range [-1.0, 1.0]. This can arguebly be regarded as a wavetable
-	// 2 arrays are used: Band-limited (# of harmonics set as per STS_NUM_SAW_HARMONICS) and Band-unlimited, approachng the mathematicsl triangle
-	float triangle_bl_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
-	float triangle_bu_wave_lookup_table[STS_NUM_WAVE_SAMPLES];
+	int interpolation = STS_INTERPOLATE_LINEAR;
+	int menu_num_Harmonics = STS_HARMONICS_AUTO; // Only touched by the UI thread, the audio thread gets the tables through triangle_bl_waves
+
+	// The triangle waves, shared read-only with all other instances. This can arguebly be regarded as a wavetable
+	// 2 kinds of tables are used: Band-limited and Band-unlimited, approachng the mathematicsl triangle
+	// The band-limited tables are a mipmap with a table per octave, limited to the # of harmonics set in the Harmonics menu
+	// They are rebuilt on the worker thread by triangle_bl_waves, process() picks up the current ones at every sample
+	STS_Wavetable_Loader triangle_bl_waves{STS_WAVE_TRIANGLE, 0};
+	const STS_Wavetable_Set *triangle_bl_wave_lookup_tables = NULL;
+	int mipmap_level = 0;	  // Mipmap level for the frequency being computed
+	float mipmap_fade = 0.f; // Crossfade into the next mipmap level
+	simd::int32_4 poly_mipmap_level = 0; // The same for 4 poly channels
+	simd::float_4 poly_mipmap_fade = 0.f;
+	float phase_inc = 0.f;			   // Phase increment per sample in cycles, for PolyBLEP
+	simd::float_4 poly_phase_inc = 0.f; // The same for 4 poly channels
+	std::shared_ptr<const STS_Wavetable> triangle_bu_wave_lookup_table;
 
 	// local class variable declarations
 	float pitch_param, phase_param, volume_param;
-	float freq = 0.f, pitch = 0.f, phase_shift = 0.f, volume_out = 0.f;
+	float freq = 0.f, pitch = 0.f, volume_out = 0.f;
+	uint32_t phase_shift = 0; // Phase shift in fixed point cycles
 	float freq_mod = 0.f, phase_mod = 0.f, volume_mod = 0.f;
 	float freq_mod_attn = 0.f, phase_mod_attn = 0.f, volume_mod_attn = 0.f;
 	int num_channels, idx;
 
+	// The poly channels are computed 4 at a time
+	simd::float_4 poly_pitch, poly_freq;
+	simd::int32_4 poly_phase;
+
+	// Hard sync of the sample being computed. The jump at the reset is that of the wave without the PolyBLEP corrections
+	int sync_band;
+	bool sync_edge;
+	float sync_since, sync_jump;
+	uint32_t edge_phase;
+	simd::float_4 poly_sync_edge, poly_sync_since, poly_sync_jump, poly_wave;
+	simd::int32_4 poly_edge_phase;
+
 	// Array of 16 phases to accomodate for polyphony
-	float phase[16] = {};
+	uint32_t phase[16] = {};
+
+	// Hard sync: the last sample of the master and the sample held back for the PolyBLEP, per poly channel
+	float sync_prev[16] = {};
+	float sync_held[16] = {};
+	int sync_Channels = -1; // Channel count they were set for, -1 while the sync input is not patched
 
 	// Maps phase & phase shift to an index in the wave table
-	float STS_My_Triangle(float phase, float phase_shift)
+	float STS_My_Triangle(uint32_t phase, uint32_t phase_shift, int band)
 	{
 		int index;
+		float frac, t, tri;
+
+		// PolyBLEP needs no table: the triangle rises from -5V to 5V over the first half cycle and falls back over the second,
+		// so its slope turns by 40V per cycle at the bottom and by -40V per cycle at the top
+		if (band == STS_BAND_POLYBLEP)
+		{
+			t = STS_Phase_Cycles(phase + phase_shift);
+			tri = 5.f - 20.f * std::fabs(t - 0.5f);
+			return (tri + 40.f * (STS_PolyBLAMP(t, phase_inc) - STS_PolyBLAMP(STS_Phase_Cycles(phase + phase_shift + 0x80000000u), phase_inc)));
+		}
+
+		// The top bits of the fixed point phase + phase_shift are the index in the wave table
+		index = STS_Wave_Index(phase + phase_shift, &frac);
+
+		if (band == STS_BAND_LIMITED)
+			return (STS_Mipmap_Sample(triangle_bl_wave_lookup_tables->up, mipmap_level, mipmap_fade, index, frac, interpolation));
+		else
+			return (STS_Wave_Sample(triangle_bu_wave_lookup_table.get(), index, frac, interpolation));
+	}
+
+	// The same for 4 poly channels at a time
+	simd::float_4 STS_My_Triangle(simd::int32_4 phase, uint32_t phase_shift, int band)
+	{
+		simd::int32_4 index;
+		simd::float_4 frac, t, tri;
+
+		if (band == STS_BAND_POLYBLEP)
+		{
+			t = STS_Phase_Cycles(phase + (int32_t)phase_shift);
+			tri = 5.f - 20.f * simd::fabs(t - 0.5f);
+			return (tri + 40.f * (STS_PolyBLAMP(t, poly_phase_inc) - STS_PolyBLAMP(STS_Phase_Cycles(phase + (int32_t)(phase_shift + 0x80000000u)), poly_phase_inc)));
+		}
 
-		// Compute the index by mapping phase + phase_shift across the total number of samples in the wave table
-		index = (int)((phase + phase_shift) * STS_NUM_WAVE_SAMPLES);
-		index = index % STS_NUM_WAVE_SAMPLES;
+		index = STS_Wave_Index(phase + (int32_t)phase_shift, &frac);
 
-		if (bandLimited)
-			return (triangle_bl_wave_lookup_table[index]);
+		if (band == STS_BAND_LIMITED)
+			return (STS_Mipmap_Sample(triangle_bl_wave_lookup_tables->up, poly_mipmap_level, poly_mipmap_fade, index, frac, interpolation));
 		else
-			return (triangle_bu_wave_lookup_table[index]);
+			return (STS_Wave_Sample(triangle_bu_wave_lookup_table.get(), index, frac, interpolation));
 	}
 
 	// Custom OnReset() to initialize wave tables and set some default values
 	void onReset() override
 	{
 		bandLimited = 0;
-		num_Harmonics = STS_DEF_NUM_HARMONICS;
-		menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		last_menu_num_Harmonics = STS_DEF_NUM_HARMONICS - 1;
-		InitTriangle_Waves();
+		interpolation = STS_INTERPOLATE_LINEAR;
+		SetNum_Harmonics(STS_HARMONICS_AUTO);
 	}
 
 	void InitTriangle_Waves()
 	{
+		// Get the band-unlimited triangle wave table from the plugin-wide cache
+		triangle_bu_wave_lookup_table = STS_Get_Wavetable(STS_WAVE_TRIANGLE, 0);
+	}
 
-		int i, j, mid, sign;
-		float iter, harmonic, h_factor, max_harmonic;
-
-		// Populate the triangle wave table
-		// Filled with a full triangle cycle, multiplied by 5.0 to reflect the default +/- 5V audio output levels
-		mid = STS_NUM_WAVE_SAMPLES / 2;
-		triangle_bu_wave_lookup_table[mid] = 5.0f; // set the mid point to +5V, in case of an odd number of samples
-		for (i = 0; i < mid; i++)
-		{
-			triangle_bu_wave_lookup_table[i] = -5.0f + 10.0f * ((float)i / mid);							// ramp up
-			triangle_bu_wave_lookup_table[STS_NUM_WAVE_SAMPLES - i - 1] = -5.0f + 10.0f * ((float)i / mid); // ramp down
-		}
-
-		// Using harmonic sine waves to mimic a band-limited triangle wave to limit aliases
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
-		{
-			iter = M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES);
-			triangle_bl_wave_lookup_table[i] = 0.0f;
-			sign = 1;
-
-			// Now loop through the odd harmonics until...
-			for (j = 1; j <= num_Harmonics * 2; j += 2)
-			{
-				h_factor = (float)j;
-
-				// Odd harmonic is added, even is subtracted
-				if (sign == 1)
-					harmonic = std::sin(h_factor * iter) / (h_factor * h_factor);
-				else
-					harmonic = -std::sin(h_factor * iter) / (h_factor * h_factor);
-
-				triangle_bl_wave_lookup_table[i] = triangle_bl_wave_lookup_table[i] + harmonic;
-				sign = sign * -1; // flip the sign
-			}
-		}
+	// Called from the UI thread when the Harmonics menu changes. The band-limited tables are rebuilt on the worker thread,
+	// the audio thread keeps playing the current tables until the new ones are ready
+	void SetNum_Harmonics(int menu_num)
+	{
+		menu_num_Harmonics = clamp(menu_num, 0, STS_HARMONICS_AUTO);
+		if (menu_num_Harmonics == STS_HARMONICS_AUTO)
+			triangle_bl_waves.SetMax_Harmonics(0);
+		else
+			triangle_bl_waves.SetMax_Harmonics(menu_num_Harmonics + 1);
+	}
 
-		// Now fnd the max harmonic value to correct the output voltage between -5.0 and 5.0 V
-		// Find tha largest harmoic first
-		max_harmonic = 0.0f;
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
-		{
-			if (triangle_bl_wave_lookup_table[i] > max_harmonic)
-				max_harmonic = triangle_bl_wave_lookup_table[i];
-		}
-		// Then correct...
-		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
-		{
-			triangle_bl_wave_lookup_table[i] *= (5.0f / max_harmonic);
-		}
+	// The mipmap levels depend on Nyquist, so rebuild them for the new sample rate
+	void onSampleRateChange(const SampleRateChangeEvent &e) override
+	{
+		triangle_bl_waves.SetSample_Rate(e.sampleRate);
 	}
 
 	Triangle_VCO()
@@ -153,6 +177,7 @@ struct Triangle_VCO : Module
 		configInput(FM_IN_INPUT, "Frequency modulation");
 		configInput(PM_IN_INPUT, "Phase modulation");
 		configInput(VM_IN_INPUT, "Volume modulation");
+		configInput(SYNC_INPUT, "Hard sync");
 		configOutput(OUTPUT_OUTPUT, "Audio Out");
 
 		InitTriangle_Waves();
@@ -161,13 +186,8 @@ struct Triangle_VCO : Module
 	void process(const ProcessArgs &args) override
 	{
 
-		// Check if we need to recompute the wave tables
-		if (last_menu_num_Harmonics != menu_num_Harmonics)
-		{
-			num_Harmonics = menu_num_Harmonics + 1;
-			InitTriangle_Waves();
-			last_menu_num_Harmonics = menu_num_Harmonics;
-		}
+		// Pick up the band-limited tables, swapping in new ones if the worker thread has finished it
+		triangle_bl_wave_lookup_tables = &triangle_bl_waves.Get();
 
 		// Get all the values from the module UI
 		pitch_param = getParam(PITCH_PARAM).getValue();
@@ -186,15 +206,14 @@ struct Triangle_VCO : Module
 		else
 			volume_out = volume_param;
 
-		// Compute the phase shift as per the controls. Make sure it is not negative, as this may happen with modulation with a bipolar signal
+		// Compute the phase shift as per the controls, in fixed point. A negative shift, as may happen with modulation with a bipolar signal, wraps around by itself
 		if (getInput(PM_IN_INPUT).isConnected())
-		{
-			phase_shift = phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER;
-			if (phase_shift < 0.0f)
-				phase_shift += 1.0f;
-		}
+			phase_shift = STS_Fixed_Phase(phase_param + phase_mod * phase_mod_attn * PHASE_MOD_MULTIPLIER);
 		else
-			phase_shift = phase_param;
+			phase_shift = STS_Fixed_Phase(phase_param);
+
+		// Hard sync reads the wave without the PolyBLEP corrections around the reset, they assume the wave has no jump there
+		sync_band = (bandLimited == STS_BAND_POLYBLEP ? STS_BAND_UNLIMITED : bandLimited);
 
 		// Is the V-In connected?
 		num_channels = getInput(V_OCT_IN_INPUT).getChannels();
@@ -216,44 +235,101 @@ struct Triangle_VCO : Module
 			else if (freq > 20000.f)
 				freq = 20000.f;
 
-			// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-			phase[0] += freq * args.sampleTime;
-			if (phase[0] >= 1.f)
-				phase[0] -= 1.f;
+			// Select the band-limited tables for this frequency
+			STS_Mipmap_Level(freq, &mipmap_level, &mipmap_fade);
+
+			phase_inc = freq * args.sampleTime;
 
-			// Compute the wave via the wave table,
-			// output to the correct channel, multiplied by the output volume
-			getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Triangle(phase[0], phase_shift));
+			if (getInput(SYNC_INPUT).isConnected())
+			{
+				// Just patched? Then start from the master and the wave as they are now. An edge against the last level of an earlier patch
+				// would be a false one, and the sample held back a stale one
+				if (sync_Channels != num_channels)
+				{
+					sync_prev[0] = getInput(SYNC_INPUT).getVoltage();
+					sync_held[0] = STS_My_Triangle(phase[0], phase_shift, bandLimited);
+				}
+
+				// Accumulate the phase, resetting it at a rising edge of the master, and smooth the jump the reset makes in the wave
+				sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getVoltage(), &sync_prev[0], &sync_since);
+				edge_phase = STS_Sync_Phase(&phase[0], phase_inc, sync_edge, sync_since);
+				if (sync_edge)
+				{
+					sync_jump = STS_My_Triangle(0, phase_shift, sync_band) - STS_My_Triangle(edge_phase, phase_shift, sync_band);
+					getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_Sync_BLEP(STS_My_Triangle(phase[0], phase_shift, sync_band), true, sync_jump, sync_since, &sync_held[0]));
+				}
+				else
+					getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_Sync_BLEP(STS_My_Triangle(phase[0], phase_shift, bandLimited), false, 0.f, 0.f, &sync_held[0]));
+			}
+			else
+			{
+				// Accumulate the phase in fixed point, it wraps around by itself at the end of the cycle
+				phase[0] += STS_Fixed_Phase(phase_inc);
+
+				// Compute the wave via the wave table,
+				// output to the correct channel, multiplied by the output volume
+				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Triangle(phase[0], phase_shift, bandLimited));
+			}
 		}
 		else
 		{
 			// Else, compute it as per the V/Oct input for each poly channel
-			// Loop through all input channels
-			for (idx = 0; idx < num_channels; idx++)
+			// Loop through the input channels, 4 at a time. A last group of less than 4 computes the unused channels too, they are ignored
+			for (idx = 0; idx < num_channels; idx += 4)
 			{
-				pitch = getInput(V_OCT_IN_INPUT).getVoltage(idx);
-				freq = pitch_param * std::pow(2.f, pitch);
+				poly_pitch = getInput(V_OCT_IN_INPUT).getVoltageSimd<simd::float_4>(idx);
+				poly_freq = pitch_param * dsp::approxExp2_taylor5(poly_pitch);
 
 				// Compute the pitch as per the controls
 				if (getInput(FM_IN_INPUT).isConnected())
-					freq = freq + freq * freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER;
+					poly_freq = poly_freq + poly_freq * (freq_mod * freq_mod_attn * FREQ_MOD_MULTIPLIER);
 
 				// limit the pitch if modulation takes it too extreme
-				if (freq < 10.f)
-					freq = 10.f;
-				else if (freq > 20000.f)
-					freq = 20000.f;
-
-				// Accumulate the phase, make sure it rotates between 0.0 and 1.0
-				phase[idx] += freq * args.sampleTime;
-				if (phase[idx] >= 1.f)
-					phase[idx] -= 1.f;
-
-				// Compute the wave via the wave table,
-				// output to the correct channel, multiplied by the output volume
-				getOutput(OUTPUT_OUTPUT).setVoltage(volume_out * STS_My_Triangle(phase[idx], phase_shift), idx);
+				poly_freq = simd::clamp(poly_freq, simd::float_4(10.f), simd::float_4(20000.f));
+
+				// Select the band-limited tables for these frequencies
+				STS_Mipmap_Level(poly_freq, &poly_mipmap_level, &poly_mipmap_fade);
+
+				poly_phase_inc = poly_freq * args.sampleTime;
+
+				if (getInput(SYNC_INPUT).isConnected())
+				{
+					// Just patched, or a new channel count? Then start from the master and the waves as they are now, as above
+					if (sync_Channels != num_channels)
+					{
+						getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx).store(&sync_prev[idx]);
+						STS_My_Triangle(simd::int32_4::load((int32_t *)&phase[idx]), phase_shift, bandLimited).store(&sync_held[idx]);
+					}
+
+					// The same per channel, a monophonic master syncs all channels
+					poly_sync_edge = STS_Sync_Edge(getInput(SYNC_INPUT).getPolyVoltageSimd<simd::float_4>(idx), &sync_prev[idx], &poly_sync_since);
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]);
+					poly_edge_phase = STS_Sync_Phase(&poly_phase, poly_phase_inc, poly_sync_edge, poly_sync_since);
+					poly_phase.store((int32_t *)&phase[idx]);
+					poly_wave = STS_My_Triangle(poly_phase, phase_shift, bandLimited);
+					poly_sync_jump = 0.f;
+					if (simd::movemask(poly_sync_edge))
+					{
+						poly_sync_jump = STS_My_Triangle(simd::int32_4(0), phase_shift, sync_band) - STS_My_Triangle(poly_edge_phase, phase_shift, sync_band);
+						if (sync_band != bandLimited)
+							poly_wave = simd::ifelse(poly_sync_edge, STS_My_Triangle(poly_phase, phase_shift, sync_band), poly_wave);
+					}
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_Sync_BLEP(poly_wave, poly_sync_edge, poly_sync_jump, poly_sync_since, &sync_held[idx]), idx);
+				}
+				else
+				{
+					// Accumulate the phases in fixed point, they wrap around by themselves at the end of the cycle
+					poly_phase = simd::int32_4::load((int32_t *)&phase[idx]) + STS_Fixed_Phase(poly_phase_inc);
+					poly_phase.store((int32_t *)&phase[idx]);
+
+					// Compute the wave via the wave table,
+					// output to the correct channels, multiplied by the output volume
+					getOutput(OUTPUT_OUTPUT).setVoltageSimd(volume_out * STS_My_Triangle(poly_phase, phase_shift, bandLimited), idx);
+				}
 			}
 		}
+
+		sync_Channels = (getInput(SYNC_INPUT).isConnected() ? num_channels : -1);
 	}
 
 	json_t *dataToJson() override
@@ -261,6 +337,7 @@ struct Triangle_VCO : Module
 		json_t *rootJ = json_object();
 
 		json_object_set_new(rootJ, "Band", json_integer(bandLimited));
+		json_object_set_new(rootJ, "Interpolation", json_integer(interpolation));
 		json_object_set_new(rootJ, "Harmonics", json_integer(menu_num_Harmonics));
 
 		return rootJ;
@@ -269,12 +346,15 @@ struct Triangle_VCO : Module
 	void dataFromJson(json_t *rootJ) override
 	{
 		json_t *bandLimitedJ = json_object_get(rootJ, "Band");
+		json_t *interpolationJ = json_object_get(rootJ, "Interpolation");
 		json_t *harmonicsJ = json_object_get(rootJ, "Harmonics");
 
 		if (bandLimitedJ)
 			bandLimited = json_integer_value(bandLimitedJ);
+		if (interpolationJ)
+			interpolation = json_integer_value(interpolationJ);
 		if (harmonicsJ)
-			menu_num_Harmonics = json_integer_value(harmonicsJ);
+			SetNum_Harmonics(json_integer_value(harmonicsJ));
 	}
 };
 
@@ -294,7 +374,7 @@ struct Triangle_VCOWidget : ModuleWidget
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 29.5)), module, Triangle_VCO::FM_ATTN_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 44.5)), module, Triangle_VCO::PM_ATTN_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 59.5)), module, Triangle_VCO::VM_ATTN_PARAM));
-		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 74.5)), module, Triangle_VCO::PITCH_PARAM));
+		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(18.5, 74.5)), module, Triangle_VCO::PITCH_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 89.5)), module, Triangle_VCO::PHASE_PARAM));
 		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(12.7, 104.5)), module, Triangle_VCO::VOLUME_PARAM));
 
@@ -302,6 +382,7 @@ struct Triangle_VCOWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 29.5)), module, Triangle_VCO::FM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 44.5)), module, Triangle_VCO::PM_IN_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 59.5)), module, Triangle_VCO::VM_IN_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(6.5, 74.5)), module, Triangle_VCO::SYNC_INPUT));
 
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(18.5, 14.0)), module, Triangle_VCO::OUTPUT_OUTPUT));
 	}
@@ -312,9 +393,13 @@ struct Triangle_VCOWidget : ModuleWidget
 
 		menu->addChild(new MenuSeparator);
 
-		menu->addChild(createIndexPtrSubmenuItem("Band", {"Unlimited", "Limited"}, &module->bandLimited));
-		menu->addChild(createIndexPtrSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "20"},
-												 &module->menu_num_Harmonics));
+		menu->addChild(createIndexPtrSubmenuItem("Band", {"Unlimited", "Limited", "PolyBLEP"}, &module->bandLimited));
+		menu->addChild(createIndexPtrSubmenuItem("Interpolation", {"None", "Linear", "Cubic"}, &module->interpolation));
+		menu->addChild(createIndexSubmenuItem("Harmonics", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "20", "Auto"},
+												 [=]()
+												 { return module->menu_num_Harmonics; },
+												 [=](size_t menu_num)
+												 { module->SetNum_Harmonics(menu_num); }));
 	}
 };
 
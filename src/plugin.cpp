@@ -10,6 +10,7 @@ void init(Plugin *p)
 	// p->addModel(modelMyModule);
 	p->addModel(modelMultiplier);
 	p->addModel(modelSplitter);
+	p->addModel(modelSplitter_Expander);
 	p->addModel(modelSine_VCO);
 	p->addModel(modelSaw_VCO);
 	p->addModel(modelTriangle_VCO);
@@ -19,6 +20,7 @@ void init(Plugin *p)
 	p->addModel(modelSpiquencer);
 	p->addModel(modelTicker);
 	p->addModel(modelHarmoblender);
+	p->addModel(modelHarmoblender_Expander);
 	p->addModel(modelSuperZzzaw);
 
 	// Any other plugin initialization may go here.
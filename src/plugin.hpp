@@ -11,6 +11,7 @@ extern Plugin *pluginInstance;
 // extern Model* modelMyModule;
 extern Model *modelMultiplier;
 extern Model *modelSplitter;
+extern Model *modelSplitter_Expander;
 extern Model *modelSine_VCO;
 extern Model *modelSaw_VCO;
 extern Model *modelTriangle_VCO;
@@ -20,6 +21,7 @@ extern Model *modelD_Octer;
 extern Model *modelSpiquencer;
 extern Model *modelTicker;
 extern Model *modelHarmoblender;
+extern Model *modelHarmoblender_Expander;
 extern Model *modelSuperZzzaw;
 
 // Some useful constants
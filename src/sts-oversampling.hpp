@@ -0,0 +1,177 @@
+#pragma once
+
+#include <rack.hpp>
+#include <cmath>
+
+// Oversampling for the modules that bend their input, so the harmonics they add above Nyquist are filtered out before they fold back.
+// The rate goes up and down in stages of 2x, each with a half-band lowpass FIR. In a half-band filter every other coefficient is 0,
+// except the centre one which is 0.5. Split into its two polyphase branches, one branch is a plain delay and only the other one
+// multiplies, so a stage costs half the taps of its filter. The filters work on 4 poly channels at a time, each lane with its own state
+
+#define STS_OVERSAMPLE_MAX_STAGES 3 // Up to 8x
+#define STS_OVERSAMPLE_MAX_FACTOR (1 << STS_OVERSAMPLE_MAX_STAGES)
+
+// Taps of the multiplying branch. The first stage needs a steep filter to keep the audio band, up to about 0.4 * sample rate.
+// The later stages only have to stop what lies past the audio band of the first stage, which a much shorter filter does
+#define STS_HALFBAND_TAPS_FIRST 24
+#define STS_HALFBAND_TAPS_NEXT 12
+
+// Kaiser window shape, for about 70 dB of stop band attenuation
+#define STS_HALFBAND_KAISER_BETA 7.f
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+inline double STS_Bessel_I0(double x)
+{
+	double sum = 1.0, term = 1.0;
+
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+// Builds the multiplying branch of a half-band filter of taps * 2 - 1 coefficients: a windowed sinc at half the Nyquist frequency.
+// The branch is normalised to sum to 0.5, which with the 0.5 of the centre tap gives exactly unity gain at DC
+inline void STS_Halfband_Design(float *coef, int taps)
+{
+	double sum = 0.0, d, r;
+	int i;
+
+	for (i = 0; i < taps; i++)
+	{
+		d = 2 * i - (taps - 1); // Odd offsets from the centre tap
+		r = d / taps;
+		coef[i] = std::sin(M_PI * d / 2.0) / (M_PI * d) * STS_Bessel_I0(STS_HALFBAND_KAISER_BETA * std::sqrt(1.0 - r * r)) / STS_Bessel_I0(STS_HALFBAND_KAISER_BETA);
+		sum += coef[i];
+	}
+	for (i = 0; i < taps; i++)
+		coef[i] *= 0.5 / sum;
+}
+
+// One 2x stage, up and down, with taps in the multiplying branch. The histories are kept twice, one after the other,
+// so the filter reads them without wrapping. The coefficients are held in all 4 lanes, ready to multiply
+template <int taps>
+struct STS_Halfband
+{
+	rack::simd::float_4 coef[taps];
+	rack::simd::float_4 up_hist[2 * taps];	 // Input of the upsampler
+	rack::simd::float_4 down_odd[2 * taps];	 // Odd samples into the downsampler, through the multiplying branch
+	rack::simd::float_4 down_even[2 * taps]; // Even samples into the downsampler, through the delay branch
+	int up_pos = 0, down_pos = 0;
+
+	// Designs the filter and clears the histories
+	void Init()
+	{
+		float design[taps];
+
+		STS_Halfband_Design(design, taps);
+		for (int i = 0; i < taps; i++)
+			coef[i] = design[i];
+		for (int i = 0; i < 2 * taps; i++)
+		{
+			up_hist[i] = 0.f;
+			down_odd[i] = 0.f;
+			down_even[i] = 0.f;
+		}
+		up_pos = 0;
+		down_pos = 0;
+	}
+
+	// Takes one sample and returns the two samples at twice the rate, the earlier one in out[0]
+	void Up(rack::simd::float_4 in, rack::simd::float_4 *out)
+	{
+		rack::simd::float_4 sum = 0.f;
+
+		if (--up_pos < 0)
+			up_pos += taps;
+		up_hist[up_pos] = in;
+		up_hist[up_pos + taps] = in;
+
+		for (int i = 0; i < taps; i++)
+			sum += coef[i] * up_hist[up_pos + i];
+
+		// Zero-stuffing halves the level, so both branches are doubled. The delay branch then is the input, 2 * 0.5
+		out[0] = 2.f * sum;
+		out[1] = up_hist[up_pos + taps / 2 - 1];
+	}
+
+	// Takes two samples, the earlier one in in[0], and returns one sample at half the rate
+	rack::simd::float_4 Down(const rack::simd::float_4 *in)
+	{
+		rack::simd::float_4 sum = 0.f;
+
+		if (--down_pos < 0)
+			down_pos += taps;
+		down_even[down_pos] = in[0];
+		down_even[down_pos + taps] = in[0];
+		down_odd[down_pos] = in[1];
+		down_odd[down_pos + taps] = in[1];
+
+		for (int i = 0; i < taps; i++)
+			sum += coef[i] * down_odd[down_pos + i];
+
+		return sum + 0.5f * down_even[down_pos + taps / 2 - 1];
+	}
+};
+
+// A cascade of 2x stages, for 4 poly channels
+struct STS_Oversampler
+{
+	int stages = -1; // Not set yet
+	STS_Halfband<STS_HALFBAND_TAPS_FIRST> first;
+	STS_Halfband<STS_HALFBAND_TAPS_NEXT> next[STS_OVERSAMPLE_MAX_STAGES - 1];
+
+	// Sets the oversampling to 2^num_stages and clears the filters. Does nothing if it already is
+	void Set_Stages(int num_stages)
+	{
+		if (num_stages == stages)
+			return;
+		stages = num_stages;
+		first.Init();
+		for (int s = 0; s < STS_OVERSAMPLE_MAX_STAGES - 1; s++)
+			next[s].Init();
+	}
+
+	// Forgets the filters, the next Set_Stages clears them
+	void Reset()
+	{
+		stages = -1;
+	}
+
+	// Takes one sample and fills out with the 2^stages samples at the oversampled rate
+	void Upsample(rack::simd::float_4 in, rack::simd::float_4 *out)
+	{
+		rack::simd::float_4 buf[STS_OVERSAMPLE_MAX_FACTOR];
+		int n = 1, s, i;
+
+		out[0] = in;
+		for (s = 0; s < stages; s++, n *= 2)
+		{
+			for (i = 0; i < n; i++)
+				buf[i] = out[i];
+			for (i = 0; i < n; i++)
+			{
+				if (s == 0)
+					first.Up(buf[i], &out[2 * i]);
+				else
+					next[s - 1].Up(buf[i], &out[2 * i]);
+			}
+		}
+	}
+
+	// Takes the 2^stages samples at the oversampled rate, overwriting them, and returns one sample at the base rate
+	rack::simd::float_4 Downsample(rack::simd::float_4 *in)
+	{
+		int n = 1 << stages, s, i;
+
+		for (s = stages - 1; s >= 0; s--)
+		{
+			n /= 2;
+			for (i = 0; i < n; i++)
+				in[i] = (s == 0 ? first.Down(&in[2 * i]) : next[s - 1].Down(&in[2 * i]));
+		}
+		return in[0];
+	}
+};
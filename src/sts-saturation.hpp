@@ -0,0 +1,55 @@
+#pragma once
+
+#include <rack.hpp>
+
+// Soft saturation curves for the modules that bend their input, on 4 poly channels at a time. Each maps the input, in units of the
+// half-width of its window, to the range -1..1 with a slope of 1 at 0, so small signals pass through unchanged. They are rational or
+// polynomial approximations of the exact curves, with their largest error stated here and measured by the benchmark against libm
+
+// Past this input the tanh approximation is held. It reaches 1 just before 5 and tanh is within 1e-4 of 1 from here on
+#define STS_TANH_CLAMP 4.8f
+
+// Where the cubic knee reaches its limit: with a slope of 1 at 0, it is 1 with a slope of 0 at 1.5
+#define STS_KNEE_END 1.5f
+
+// tanh, with the 7th/6th order rational from its continued fraction. Largest error 7.2e-5, at the clamp
+inline rack::simd::float_4 STS_Tanh(rack::simd::float_4 x)
+{
+	rack::simd::float_4 x2;
+
+	x = rack::simd::clamp(x, -STS_TANH_CLAMP, STS_TANH_CLAMP);
+	x2 = x * x;
+	return x * (135135.f + x2 * (17325.f + x2 * (378.f + x2))) / (135135.f + x2 * (62370.f + x2 * (3150.f + 28.f * x2)));
+}
+
+// Cubic soft knee: x - 4 * x^3 / 27 up to the end of the knee, then held. Exact but for float rounding
+inline rack::simd::float_4 STS_Soft_Knee(rack::simd::float_4 x)
+{
+	x = rack::simd::clamp(x, -STS_KNEE_END, STS_KNEE_END);
+	return x - (4.f / 27.f) * x * x * x;
+}
+
+// Asymmetric diode: the soft exponential knee 1 - e^-x of a diode starting to conduct above 0, the harder cubic knee below.
+// The exponential is Rack's 5th order approximation of 2^x. Largest error 2e-7
+inline rack::simd::float_4 STS_Diode(rack::simd::float_4 x)
+{
+	rack::simd::float_4 up;
+
+	// Held past 2^-40, so the exponent of the approximation stays in range
+	up = 1.f - rack::dsp::approxExp2_taylor5(-(float)M_LOG2E * rack::simd::clamp(x, 0.f, 40.f / (float)M_LOG2E));
+	return rack::simd::ifelse(x > 0.f, up, STS_Soft_Knee(x));
+}
+
+// sin, folding the input back at every multiple of pi / 2. The input is brought into -pi / 2..pi / 2 by taking off the nearest
+// multiple of pi, which flips the sign when it is odd. There, the Taylor series up to x^11, within 6e-8. Taking off the multiple of pi
+// in float adds to that as the input grows: largest error 7e-7 up to 20
+inline rack::simd::float_4 STS_Sine(rack::simd::float_4 x)
+{
+	rack::simd::float_4 n, x2, sign;
+
+	n = rack::simd::round(x * (float)M_1_PI);
+	x -= n * (float)M_PI;
+	sign = 1.f - 4.f * (0.5f * n - rack::simd::floor(0.5f * n)); // 1 when n is even, -1 when odd
+	x2 = x * x;
+	return sign * x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f - x2 / 39916800.f)))));
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+// Sorting networks for the voltages of a polyphonic cable, up to 16 channels. A network is a fixed list of compare-and-swaps,
+// each a min and a max without branches, so sorting costs the same whatever the voltages. The list is Batcher's odd-even merge sort,
+// written out by the compiler from the templates below for the next power of 2 and pruned to N: with the missing channels taken
+// as +infinity, every compare-and-swap that reaches past N leaves both sides as they are, so it is dropped at compile time.
+// For 2, 3 and 4 channels this gives the smallest networks there are, for 16 it takes 63 compare-and-swaps against the best known 60
+
+#define STS_SORT_MAX_CHANNELS 16
+
+// Compare-and-swap of channels i and j, i < j, into ascending order. Dropped when j is past the N channels being sorted.
+// Written as selects, these compile to a single min and max instruction each. std::fmin and std::fmax keep to the rules for NaN
+// and become library calls
+template <int N, int i, int j, bool inside = (j < N)>
+struct STS_Sort_Pair
+{
+	static inline void Apply(float *v)
+	{
+		float a = v[i], b = v[j];
+
+		v[i] = b < a ? b : a;
+		v[j] = a < b ? b : a;
+	}
+};
+
+template <int N, int i, int j>
+struct STS_Sort_Pair<N, i, j, false>
+{
+	static inline void Apply(float *) {}
+};
+
+// The last step of a merge: compare-and-swap each channel from i on, every step channels, with the one r channels up, short of last
+template <int N, int i, int last, int step, int r, bool more = (i + r < last)>
+struct STS_Sort_Run
+{
+	static inline void Apply(float *v)
+	{
+		STS_Sort_Pair<N, i, i + r>::Apply(v);
+		STS_Sort_Run<N, i + step, last, step, r>::Apply(v);
+	}
+};
+
+template <int N, int i, int last, int step, int r>
+struct STS_Sort_Run<N, i, last, step, r, false>
+{
+	static inline void Apply(float *) {}
+};
+
+// Merges the two sorted halves of the size channels from lo, looking at every r-th channel: first the even and the odd channels
+// on their own, then the neighbours between them
+template <int N, int lo, int size, int r, bool split = (2 * r < size)>
+struct STS_Sort_Merge
+{
+	static inline void Apply(float *v)
+	{
+		STS_Sort_Merge<N, lo, size, 2 * r>::Apply(v);
+		STS_Sort_Merge<N, lo + r, size - r, 2 * r>::Apply(v);
+		STS_Sort_Run<N, lo + r, lo + size - 1, 2 * r, r>::Apply(v);
+	}
+};
+
+template <int N, int lo, int size, int r>
+struct STS_Sort_Merge<N, lo, size, r, false>
+{
+	static inline void Apply(float *v)
+	{
+		STS_Sort_Pair<N, lo, lo + r>::Apply(v);
+	}
+};
+
+// Sorts the size channels from lo: both halves, then merges them. size is a power of 2
+template <int N, int lo, int size>
+struct STS_Sort_Range
+{
+	static inline void Apply(float *v)
+	{
+		STS_Sort_Range<N, lo, size / 2>::Apply(v);
+		STS_Sort_Range<N, lo + size / 2, size / 2>::Apply(v);
+		STS_Sort_Merge<N, lo, size, 1>::Apply(v);
+	}
+};
+
+template <int N, int lo>
+struct STS_Sort_Range<N, lo, 1>
+{
+	static inline void Apply(float *) {}
+};
+
+// The power of 2 from p up that holds n channels
+constexpr int STS_Sort_Size(int n, int p = 1)
+{
+	return p >= n ? p : STS_Sort_Size(n, 2 * p);
+}
+
+// Sorts the first N of v ascending
+template <int N>
+void STS_Sort_Network(float *v)
+{
+	STS_Sort_Range<N, 0, STS_Sort_Size(N)>::Apply(v);
+}
+
+// Sorts the first num_channels of v ascending, with the network for that many channels
+inline void STS_Sort(float *v, int num_channels)
+{
+	static void (*const networks[STS_SORT_MAX_CHANNELS + 1])(float *) = {
+		STS_Sort_Network<0>, STS_Sort_Network<1>, STS_Sort_Network<2>, STS_Sort_Network<3>, STS_Sort_Network<4>, STS_Sort_Network<5>,
+		STS_Sort_Network<6>, STS_Sort_Network<7>, STS_Sort_Network<8>, STS_Sort_Network<9>, STS_Sort_Network<10>, STS_Sort_Network<11>,
+		STS_Sort_Network<12>, STS_Sort_Network<13>, STS_Sort_Network<14>, STS_Sort_Network<15>, STS_Sort_Network<16>};
+
+	networks[num_channels](v);
+}
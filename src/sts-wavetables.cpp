@@ -0,0 +1,520 @@
+#include "plugin.hpp"
+#include "sts-wavetables.hpp"
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <math.h>
+
+// The cache only holds weak references, so a table is freed as soon as the last module instance using it releases it
+static std::map<int, std::weak_ptr<const STS_Wavetable>> wavetable_cache;
+static std::mutex wavetable_cache_mutex;
+
+// Find the largest value in the table and scale the table to peak at 5.0 V
+static void STS_Normalize_Wave(STS_Wavetable *wave)
+{
+	int i;
+	float max_harmonic = 0.0f;
+
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+	{
+		if (wave->samples[i] > max_harmonic)
+			max_harmonic = wave->samples[i];
+	}
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		wave->samples[i] *= (5.0f / max_harmonic);
+}
+
+// Copy the first samples past the end, for the interpolators
+static void STS_Fill_Guard(STS_Wavetable *wave)
+{
+	int i;
+
+	for (i = 0; i < STS_WAVE_GUARD; i++)
+		wave->samples[STS_NUM_WAVE_SAMPLES + i] = wave->samples[i];
+}
+
+// Reverse the table, to turn a down ramp into an up ramp
+static void STS_Reverse_Wave(STS_Wavetable *wave)
+{
+	int i;
+	float temp;
+
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES / 2; i++)
+	{
+		temp = wave->samples[i];
+		wave->samples[i] = wave->samples[STS_NUM_WAVE_SAMPLES - i - 1];
+		wave->samples[STS_NUM_WAVE_SAMPLES - i - 1] = temp;
+	}
+}
+
+static void STS_Build_Sine(STS_Wavetable *wave)
+{
+	int i;
+
+	// Filled with a full sine cycle, multiplied by 5.0 to reflect the default +/- 5V audio output levels
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		wave->samples[i] = 5.0f * std::sin(M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES));
+}
+
+// One cycle of a unit sine. The harmonics are read from it at index h * i, which is exact as long as h * i is wrapped to the table,
+// and saves a sin() call per harmonic per sample when building tables with hundreds of harmonics
+static void STS_Build_Unit_Sine(float *sine)
+{
+	int i;
+
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		sine[i] = std::sin(M_2PI * ((float)i / STS_NUM_WAVE_SAMPLES));
+}
+
+static void STS_Build_Saw(STS_Wavetable *wave, int num_Harm, int rampDir)
+{
+	int i, j;
+	float sine[STS_NUM_WAVE_SAMPLES];
+
+	if (num_Harm == 0)
+	{
+		// Band-unlimited up ramp
+		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+			wave->samples[i] = -5.0f + 10.0f * ((float)i / STS_NUM_WAVE_SAMPLES);
+
+		if (rampDir == STS_RAMP_DOWN)
+			STS_Reverse_Wave(wave);
+		return;
+	}
+
+	// Using harmonic sine waves to mimic a band-limited sawtooth wave to limit aliases
+	// Sawtooth = all harmonics 2nd 3rd 4th &c. where 2nd = ½, 3rd = ¹/₃ & 4th = ¼ volume. This sum is a down ramp
+	STS_Build_Unit_Sine(sine);
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+	{
+		wave->samples[i] = 0.0f;
+
+		for (j = 1; j <= num_Harm; j++)
+			wave->samples[i] += sine[(j * i) & STS_WAVE_MASK] / (float)j;
+	}
+
+	STS_Normalize_Wave(wave);
+	if (rampDir == STS_RAMP_UP)
+		STS_Reverse_Wave(wave);
+}
+
+static void STS_Build_Triangle(STS_Wavetable *wave, int num_Harm)
+{
+	int i, j, mid;
+	float sign;
+	float sine[STS_NUM_WAVE_SAMPLES];
+
+	if (num_Harm == 0)
+	{
+		mid = STS_NUM_WAVE_SAMPLES / 2;
+		wave->samples[mid] = 5.0f; // set the mid point to +5V, in case of an odd number of samples
+		for (i = 0; i < mid; i++)
+		{
+			wave->samples[i] = -5.0f + 10.0f * ((float)i / mid);							// ramp up
+			wave->samples[STS_NUM_WAVE_SAMPLES - i - 1] = -5.0f + 10.0f * ((float)i / mid); // ramp down
+		}
+		return;
+	}
+
+	// Using harmonic sine waves to mimic a band-limited triangle wave to limit aliases
+	// Triangle = odd harmonics only at ⅟harmonic², alternating in sign
+	STS_Build_Unit_Sine(sine);
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+	{
+		wave->samples[i] = 0.0f;
+		sign = 1.0f;
+
+		for (j = 1; j <= num_Harm * 2; j += 2)
+		{
+			wave->samples[i] += sign * sine[(j * i) & STS_WAVE_MASK] / (float)(j * j);
+			sign = -sign;
+		}
+	}
+
+	STS_Normalize_Wave(wave);
+}
+
+static void STS_Build_Square(STS_Wavetable *wave, int num_Harm)
+{
+	int i, j;
+	float sine[STS_NUM_WAVE_SAMPLES];
+
+	if (num_Harm == 0)
+	{
+		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+			wave->samples[i] = (i < STS_NUM_WAVE_SAMPLES / 2) ? 5.0f : -5.0f;
+		return;
+	}
+
+	// Using harmonic sine waves to mimic a band-limited square wave to limit aliases
+	// Square = odd harmonics only, ¹/3 of 3rd, ¹/5 of 5th &c. (⅟harmonic)
+	STS_Build_Unit_Sine(sine);
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+	{
+		wave->samples[i] = 0.0f;
+
+		for (j = 1; j <= num_Harm * 2; j += 2)
+			wave->samples[i] += sine[(j * i) & STS_WAVE_MASK] / (float)j;
+	}
+
+	STS_Normalize_Wave(wave);
+}
+
+std::shared_ptr<const STS_Wavetable> STS_Get_Wavetable(int waveform, int num_Harm, int rampDir)
+{
+	std::shared_ptr<const STS_Wavetable> wave;
+	STS_Wavetable *new_wave;
+	int key;
+
+	// Only the sawtooth has a direction, and the sine has no harmonics
+	if (waveform != STS_WAVE_SAW)
+		rampDir = STS_RAMP_UP;
+	if (waveform == STS_WAVE_SINE)
+		num_Harm = 0;
+	key = (waveform << 16) | (rampDir << 15) | num_Harm;
+
+	std::lock_guard<std::mutex> lock(wavetable_cache_mutex);
+
+	// Already held by another instance? Then share it
+	auto it = wavetable_cache.find(key);
+	if (it != wavetable_cache.end())
+	{
+		wave = it->second.lock();
+		if (wave)
+			return wave;
+	}
+
+	// Else build it and remember it for the next instance
+	new_wave = new STS_Wavetable;
+	switch (waveform)
+	{
+	case STS_WAVE_SAW:
+		STS_Build_Saw(new_wave, num_Harm, rampDir);
+		break;
+	case STS_WAVE_TRIANGLE:
+		STS_Build_Triangle(new_wave, num_Harm);
+		break;
+	case STS_WAVE_SQUARE:
+		STS_Build_Square(new_wave, num_Harm);
+		break;
+	default:
+		STS_Build_Sine(new_wave);
+		break;
+	}
+	STS_Fill_Guard(new_wave);
+	wave.reset(new_wave);
+
+	// Drop the entries of tables that are no longer held by anyone
+	for (auto e = wavetable_cache.begin(); e != wavetable_cache.end();)
+	{
+		if (e->second.expired())
+			e = wavetable_cache.erase(e);
+		else
+			++e;
+	}
+	wavetable_cache[key] = wave;
+
+	return wave;
+}
+
+// The worker thread building the tables for all loaders and bakers, started on the first request
+// Declared after the cache, so it is stopped before the cache is destroyed
+static struct STS_Wavetable_Worker
+{
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable work_cv; // Signals a new request or stop
+	std::condition_variable done_cv; // Signals a finished build
+	STS_Worker_Job *first = NULL;	 // Queue of jobs, linked through the jobs
+	STS_Worker_Job *last = NULL;
+	STS_Worker_Job *busy = NULL;
+	bool stop = false;
+
+	~STS_Wavetable_Worker()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		work_cv.notify_one();
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			work_cv.wait(lock, [this] { return stop || first; });
+			if (stop)
+				return;
+
+			busy = first;
+			first = busy->next;
+			if (!first)
+				last = NULL;
+			busy->next = NULL;
+			busy->queued = false;
+
+			// Build without holding the lock, so the UI thread can queue more requests meanwhile
+			lock.unlock();
+			busy->Build();
+			lock.lock();
+
+			busy = NULL;
+			done_cv.notify_all();
+		}
+	}
+
+	// Both under the lock
+	void Push(STS_Worker_Job *job)
+	{
+		if (!thread.joinable())
+			thread = std::thread(&STS_Wavetable_Worker::Run, this);
+
+		if (!job->queued)
+		{
+			job->queued = true;
+			if (last)
+				last->next = job;
+			else
+				first = job;
+			last = job;
+		}
+		work_cv.notify_one();
+	}
+
+	void Remove(STS_Worker_Job *job)
+	{
+		STS_Worker_Job *prev = NULL, *j;
+
+		if (!job->queued)
+			return;
+		for (j = first; j != job; j = j->next)
+			prev = j;
+		if (prev)
+			prev->next = job->next;
+		else
+			first = job->next;
+		if (last == job)
+			last = prev;
+		job->next = NULL;
+		job->queued = false;
+	}
+} wavetable_worker;
+
+void STS_Worker_Job::Request()
+{
+	std::lock_guard<std::mutex> lock(wavetable_worker.mutex);
+
+	wavetable_worker.Push(this);
+}
+
+bool STS_Worker_Job::Try_Request()
+{
+	std::unique_lock<std::mutex> lock(wavetable_worker.mutex, std::try_to_lock);
+
+	// The first request starts the thread, which is no job for the audio thread
+	if (!lock.owns_lock() || !wavetable_worker.thread.joinable())
+		return false;
+	wavetable_worker.Push(this);
+	return true;
+}
+
+void STS_Worker_Job::Cancel()
+{
+	std::unique_lock<std::mutex> lock(wavetable_worker.mutex);
+
+	wavetable_worker.Remove(this);
+	wavetable_worker.done_cv.wait(lock, [this] { return wavetable_worker.busy != this; });
+}
+
+// Number of harmonics for one mipmap level: all harmonics of the highest fundamental of the level that stay below Nyquist
+// The triangle and square only count the odd harmonics. Never more than the table can hold, and never less than the fundamental
+static int STS_Mipmap_Harmonics(int waveform, int level, int max_Harm, float sample_rate)
+{
+	float top_freq = STS_MIPMAP_BASE_FREQ * (float)(1 << level);
+	int num_Harm = (int)(0.5f * sample_rate / top_freq);
+	int max_Table = STS_NUM_WAVE_SAMPLES / 2 - 1;
+
+	if (waveform != STS_WAVE_SAW)
+	{
+		num_Harm = (num_Harm + 1) / 2;
+		max_Table = STS_NUM_WAVE_SAMPLES / 4;
+	}
+	if (max_Harm > 0 && num_Harm > max_Harm)
+		num_Harm = max_Harm;
+	if (num_Harm > max_Table)
+		num_Harm = max_Table;
+	if (num_Harm < 1)
+		num_Harm = 1;
+
+	return num_Harm;
+}
+
+STS_Wavetable_Loader::STS_Wavetable_Loader(int waveform, int max_Harm, float sample_rate) : waveform(waveform), requested_max_Harm(max_Harm), requested_sample_rate(sample_rate), ready(false)
+{
+	Build_Set(&sets[0]);
+}
+
+STS_Wavetable_Loader::~STS_Wavetable_Loader()
+{
+	Cancel();
+}
+
+void STS_Wavetable_Loader::SetMax_Harmonics(int max_Harm)
+{
+	requested_max_Harm = max_Harm;
+	Request();
+}
+
+void STS_Wavetable_Loader::SetSample_Rate(float sample_rate)
+{
+	requested_sample_rate = sample_rate;
+	Request();
+}
+
+void STS_Wavetable_Loader::Build_Set(STS_Wavetable_Set *set)
+{
+	int level, num_Harm;
+	int max_Harm = requested_max_Harm;
+	float sample_rate = requested_sample_rate;
+
+	for (level = 0; level < STS_NUM_MIPMAP_LEVELS; level++)
+	{
+		num_Harm = STS_Mipmap_Harmonics(waveform, level, max_Harm, sample_rate);
+		set->up[level] = STS_Get_Wavetable(waveform, num_Harm, STS_RAMP_UP);
+		if (waveform == STS_WAVE_SAW)
+			set->down[level] = STS_Get_Wavetable(waveform, num_Harm, STS_RAMP_DOWN);
+	}
+}
+
+void STS_Wavetable_Loader::Build()
+{
+	bool expected = true;
+
+	// If the audio thread has not picked up the last set yet, take it back and build into it again
+	// Else the audio thread has moved on to the last set, so the other one is free
+	if (!ready.compare_exchange_strong(expected, false))
+		build ^= 1;
+
+	Build_Set(&sets[build]);
+
+	ready.store(true, std::memory_order_release);
+}
+
+void STS_Additive_Baker::Set_Partials(const STS_Partial *partials, int num)
+{
+	STS_Partial silent;
+	int i;
+
+	if (num == sent_num)
+	{
+		for (i = 0; i < num; i++)
+		{
+			if (partials[i] != sent[i])
+				break;
+		}
+		if (i == num)
+			return;
+	}
+
+	// Never wait for the worker thread: if it holds a lock, try again at the next sample
+	std::unique_lock<std::mutex> lock(requested_mutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return;
+	for (i = 0; i < STS_MAX_PARTIALS; i++)
+		requested[i] = (i < num ? partials[i] : silent);
+	requested_generation = sent_generation + 1;
+	lock.unlock();
+
+	if (Try_Request())
+	{
+		for (i = 0; i < num; i++)
+			sent[i] = partials[i];
+		sent_num = num;
+		sent_generation++;
+	}
+}
+
+// Adds level * partial into the sum, in the same +/- 5V range as the sine table
+static void STS_Add_Partial(double *sum, const STS_Partial &partial, double level)
+{
+	double phase_shift = partial.phase_shift * (1.0 / 4294967296.0);
+	int i;
+
+	if (level == 0.0)
+		return;
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		sum[i] += 5.0 * level * std::sin(2.0 * M_PI * ((double)((partial.multiplication * i) & STS_WAVE_MASK) / STS_NUM_WAVE_SAMPLES + phase_shift));
+}
+
+void STS_Bake_Partials(STS_Wavetable *table, const STS_Partial *partials, int num)
+{
+	std::unique_ptr<double[]> sum(new double[STS_NUM_WAVE_SAMPLES]());
+	int i;
+
+	for (i = 0; i < num; i++)
+		STS_Add_Partial(sum.get(), partials[i], partials[i].level);
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		table->samples[i] = (float)sum[i];
+	STS_Fill_Guard(table);
+}
+
+void STS_Additive_Baker::Build()
+{
+	STS_Partial wanted[STS_MAX_PARTIALS];
+	uint32_t wanted_generation;
+	bool expected = true;
+	int i, num_Changed = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(requested_mutex);
+		for (i = 0; i < STS_MAX_PARTIALS; i++)
+			wanted[i] = requested[i];
+		wanted_generation = requested_generation;
+	}
+
+	for (i = 0; i < STS_MAX_PARTIALS; i++)
+	{
+		if (wanted[i] != applied[i])
+			num_Changed++;
+	}
+
+	// Many partials changed, as when loading a patch? Then start from scratch, else swap only the changed partials
+	if (num_Changed > STS_MAX_PARTIALS / 2)
+	{
+		for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+			sum[i] = 0.0;
+		for (i = 0; i < STS_MAX_PARTIALS; i++)
+			STS_Add_Partial(sum, wanted[i], wanted[i].level);
+	}
+	else
+	{
+		for (i = 0; i < STS_MAX_PARTIALS; i++)
+		{
+			if (wanted[i] != applied[i])
+			{
+				STS_Add_Partial(sum, applied[i], -applied[i].level);
+				STS_Add_Partial(sum, wanted[i], wanted[i].level);
+			}
+		}
+	}
+	for (i = 0; i < STS_MAX_PARTIALS; i++)
+		applied[i] = wanted[i];
+
+	// If the audio thread has not picked up the last table yet, take it back and build into it again
+	// Else the audio thread has moved on to the last table, so the other one is free
+	if (!ready.compare_exchange_strong(expected, false))
+		build ^= 1;
+
+	for (i = 0; i < STS_NUM_WAVE_SAMPLES; i++)
+		tables[build].samples[i] = (float)sum[i];
+	STS_Fill_Guard(&tables[build]);
+	generation[build] = wanted_generation;
+
+	ready.store(true, std::memory_order_release);
+}
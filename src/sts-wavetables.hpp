@@ -0,0 +1,471 @@
+#pragma once
+
+#include <rack.hpp>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+// Plugin-wide cache of the wave tables used by the VCO's
+// Identical tables are built once and shared read-only by all module instances. A table lives as long as one instance holds it
+
+// Tables are a power of two long, so the index wraps with a bitmask. They carry 3 guard points past the end,
+// copies of the first samples, so the interpolators can read ahead without wrapping
+#define STS_WAVE_BITS 11
+#define STS_NUM_WAVE_SAMPLES (1 << STS_WAVE_BITS)
+#define STS_WAVE_MASK (STS_NUM_WAVE_SAMPLES - 1)
+#define STS_WAVE_GUARD 3
+
+// Phases are 32-bit fixed point cycles: a full cycle is 2^32, so the phase wraps around by itself and never drifts.
+// The top STS_WAVE_BITS are the table index, the bits below are the fraction towards the next sample
+#define STS_PHASE_FRAC_BITS (32 - STS_WAVE_BITS)
+
+// Interpolation between table samples
+#define STS_INTERPOLATE_NONE 0
+#define STS_INTERPOLATE_LINEAR 1
+#define STS_INTERPOLATE_CUBIC 2
+
+// Waveforms in the cache
+#define STS_WAVE_SINE 0
+#define STS_WAVE_SAW 1
+#define STS_WAVE_TRIANGLE 2
+#define STS_WAVE_SQUARE 3
+
+// Ramp direction, only relevant for the sawtooth
+#define STS_RAMP_UP 0
+#define STS_RAMP_DOWN 1
+
+// Band-limited waves are normalised to peak at 5V. For the sawtooth that takes out its Gibbs overshoot,
+// so its ramp only rises 10V / STS_SAW_GIBBS over the cycle
+#define STS_SAW_GIBBS 1.17898f
+
+// One single-cycle wave, as values in the range [-5.0, 5.0] to reflect the default +/- 5V audio output levels
+struct STS_Wavetable
+{
+	float samples[STS_NUM_WAVE_SAMPLES + STS_WAVE_GUARD];
+};
+
+// Get a wave table from the cache, building it if no instance holds it yet
+// num_Harm = 0 returns the band-unlimited (mathematical) wave, else a band-limited wave built from num_Harm harmonics
+// For the sawtooth all harmonics are counted, for the triangle and square only the odd harmonics
+std::shared_ptr<const STS_Wavetable> STS_Get_Wavetable(int waveform, int num_Harm = 0, int rampDir = STS_RAMP_UP);
+
+// Converts cycles (a phase, or a phase increment as freq * sampleTime) to fixed point, wrapping whole cycles away
+inline uint32_t STS_Fixed_Phase(float cycles)
+{
+	return ((uint32_t)(int64_t)(cycles * 4294967296.f));
+}
+
+// Maps a fixed point phase to a table index and the fraction towards the next sample
+inline int STS_Wave_Index(uint32_t phase, float *frac)
+{
+	*frac = (float)(phase & ((1u << STS_PHASE_FRAC_BITS) - 1)) * (1.f / (1u << STS_PHASE_FRAC_BITS));
+	return ((int)(phase >> STS_PHASE_FRAC_BITS));
+}
+
+// Reads a table at index + frac from STS_Wave_Index()
+inline float STS_Wave_Sample(const STS_Wavetable *wave, int index, float frac, int interpolation)
+{
+	const float *y;
+
+	switch (interpolation)
+	{
+	case STS_INTERPOLATE_LINEAR:
+		y = &wave->samples[index];
+		return (y[0] + frac * (y[1] - y[0]));
+	case STS_INTERPOLATE_CUBIC:
+	{
+		// Cubic Hermite (Catmull-Rom) through y[0]..y[3], between y[1] and y[2]
+		y = &wave->samples[(index - 1) & STS_WAVE_MASK];
+		float c1 = 0.5f * (y[2] - y[0]);
+		float c2 = y[0] - 2.5f * y[1] + 2.f * y[2] - 0.5f * y[3];
+		float c3 = 0.5f * (y[3] - y[0]) + 1.5f * (y[1] - y[2]);
+		return (((c3 * frac + c2) * frac + c1) * frac + y[1]);
+	}
+	default:
+		return (wave->samples[index]);
+	}
+}
+
+// Band-limited tables come as a mipmap: one table per octave of the fundamental, each with as many harmonics as fit below Nyquist
+// Level 0 is for fundamentals up to STS_MIPMAP_BASE_FREQ, each next level for one octave higher, the last level up to 20480 Hz
+#define STS_NUM_MIPMAP_LEVELS 11
+#define STS_MIPMAP_BASE_FREQ 20.f
+
+// The band-limited tables one module plays from
+struct STS_Wavetable_Set
+{
+	std::shared_ptr<const STS_Wavetable> up[STS_NUM_MIPMAP_LEVELS];
+	std::shared_ptr<const STS_Wavetable> down[STS_NUM_MIPMAP_LEVELS]; // Only used for the sawtooth
+};
+
+// Selects the mipmap level for a fundamental of freq Hz. The level is the first one without aliasing at freq,
+// fade moves linearly from 0 to 1 across the octave to crossfade into the next, duller level, so there is no jump in timbre at the octave boundaries
+inline void STS_Mipmap_Level(float freq, int *level, float *fade)
+{
+	// freq / STS_MIPMAP_BASE_FREQ = mantissa * 2^level, with mantissa in [0.5, 1)
+	*fade = 2.f * std::frexp(freq * (1.f / STS_MIPMAP_BASE_FREQ), level) - 1.f;
+
+	if (*level < 0)
+	{
+		*level = 0;
+		*fade = 0.f;
+	}
+	else if (*level > STS_NUM_MIPMAP_LEVELS - 2)
+	{
+		*level = STS_NUM_MIPMAP_LEVELS - 2;
+		*fade = 1.f;
+	}
+}
+
+// Reads one sample of a mipmapped wave at the level and fade from STS_Mipmap_Level()
+inline float STS_Mipmap_Sample(const std::shared_ptr<const STS_Wavetable> *levels, int level, float fade, int index, float frac, int interpolation)
+{
+	float low = STS_Wave_Sample(levels[level].get(), index, frac, interpolation);
+
+	return (low + fade * (STS_Wave_Sample(levels[level + 1].get(), index, frac, interpolation) - low));
+}
+
+// SIMD versions of the above, computing 4 poly channels at a time. The phases are the same fixed point cycles, held in int32 lanes
+// so they wrap around just the same. Only the table reads are per lane, all the arithmetic around them is vectorised
+
+// Converts 4 phase increments to fixed point. The int32 conversion saturates instead of wrapping, so whole cycles are taken off first
+inline rack::simd::int32_4 STS_Fixed_Phase(rack::simd::float_4 cycles)
+{
+	cycles -= rack::simd::round(cycles);
+	return (rack::simd::int32_4(cycles * 4294967296.f));
+}
+
+// Maps 4 fixed point phases to table indices and the fractions towards the next samples
+inline rack::simd::int32_4 STS_Wave_Index(rack::simd::int32_4 phase, rack::simd::float_4 *frac)
+{
+	*frac = rack::simd::float_4(phase & (int32_t)((1u << STS_PHASE_FRAC_BITS) - 1)) * (1.f / (1u << STS_PHASE_FRAC_BITS));
+	// The shift is arithmetic, so mask off the sign bits it drags in
+	return ((phase >> STS_PHASE_FRAC_BITS) & STS_WAVE_MASK);
+}
+
+// Gathers 4 samples, one per lane, each from its own table at index + offset
+inline rack::simd::float_4 STS_Wave_Gather(const STS_Wavetable *const *wave, rack::simd::int32_4 index, int offset)
+{
+	return (rack::simd::float_4(wave[0]->samples[index[0] + offset], wave[1]->samples[index[1] + offset],
+								wave[2]->samples[index[2] + offset], wave[3]->samples[index[3] + offset]));
+}
+
+// Reads 4 tables, one per lane, at index + frac from STS_Wave_Index()
+inline rack::simd::float_4 STS_Wave_Sample(const STS_Wavetable *const *wave, rack::simd::int32_4 index, rack::simd::float_4 frac, int interpolation)
+{
+	using rack::simd::float_4;
+
+	switch (interpolation)
+	{
+	case STS_INTERPOLATE_LINEAR:
+	{
+		float_4 y0 = STS_Wave_Gather(wave, index, 0);
+		float_4 y1 = STS_Wave_Gather(wave, index, 1);
+		return (y0 + frac * (y1 - y0));
+	}
+	case STS_INTERPOLATE_CUBIC:
+	{
+		// Cubic Hermite (Catmull-Rom) through y0..y3, between y1 and y2
+		index = (index - 1) & STS_WAVE_MASK;
+		float_4 y0 = STS_Wave_Gather(wave, index, 0);
+		float_4 y1 = STS_Wave_Gather(wave, index, 1);
+		float_4 y2 = STS_Wave_Gather(wave, index, 2);
+		float_4 y3 = STS_Wave_Gather(wave, index, 3);
+		float_4 c1 = 0.5f * (y2 - y0);
+		float_4 c2 = y0 - 2.5f * y1 + 2.f * y2 - 0.5f * y3;
+		float_4 c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+		return (((c3 * frac + c2) * frac + c1) * frac + y1);
+	}
+	default:
+		return (STS_Wave_Gather(wave, index, 0));
+	}
+}
+
+// Reads one table in all 4 lanes
+inline rack::simd::float_4 STS_Wave_Sample(const STS_Wavetable *wave, rack::simd::int32_4 index, rack::simd::float_4 frac, int interpolation)
+{
+	const STS_Wavetable *waves[4] = {wave, wave, wave, wave};
+
+	return (STS_Wave_Sample(waves, index, frac, interpolation));
+}
+
+// Selects the mipmap levels for 4 fundamentals, as STS_Mipmap_Level() above. freq must be positive
+inline void STS_Mipmap_Level(rack::simd::float_4 freq, rack::simd::int32_4 *level, rack::simd::float_4 *fade)
+{
+	using rack::simd::float_4;
+	using rack::simd::int32_4;
+
+	// frexp() straight from the float bits: the exponent gives the level, the mantissa with the exponent of 0.5 the fade
+	int32_4 bits = int32_4::cast(freq * (1.f / STS_MIPMAP_BASE_FREQ));
+	float_4 octave = float_4(((bits >> 23) & 0xff) - 126);
+	*fade = 2.f * float_4::cast((bits & 0x007fffff) | 0x3f000000) - 1.f;
+
+	*fade = rack::simd::ifelse(octave < 0.f, float_4(0.f), *fade);
+	*fade = rack::simd::ifelse(octave > (float)(STS_NUM_MIPMAP_LEVELS - 2), float_4(1.f), *fade);
+	*level = int32_4(rack::simd::clamp(octave, float_4(0.f), float_4((float)(STS_NUM_MIPMAP_LEVELS - 2))));
+}
+
+// Reads 4 samples of a mipmapped wave at the levels and fades from STS_Mipmap_Level()
+inline rack::simd::float_4 STS_Mipmap_Sample(const std::shared_ptr<const STS_Wavetable> *levels, rack::simd::int32_4 level, rack::simd::float_4 fade,
+											 rack::simd::int32_4 index, rack::simd::float_4 frac, int interpolation)
+{
+	const STS_Wavetable *low[4], *high[4];
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		low[lane] = levels[level[lane]].get();
+		high[lane] = levels[level[lane] + 1].get();
+	}
+
+	rack::simd::float_4 low_sample = STS_Wave_Sample(low, index, frac, interpolation);
+
+	return (low_sample + fade * (STS_Wave_Sample(high, index, frac, interpolation) - low_sample));
+}
+
+// Band modes of the VCO's: the mathematical wave read from a table, the band-limited mipmap, or PolyBLEP
+#define STS_BAND_UNLIMITED 0
+#define STS_BAND_LIMITED 1
+#define STS_BAND_POLYBLEP 2
+
+// PolyBLEP computes the mathematical wave straight from the phase, without tables, and takes the aliasing out of its jumps
+// and corners by adding a polynomial residual over the sample before and the sample after each of them
+// t is the phase in cycles since the jump or corner, dt the phase increment per sample in cycles
+
+// Converts a fixed point phase to cycles in [0, 1). The top 24 bits are exact in a float
+inline float STS_Phase_Cycles(uint32_t phase)
+{
+	return ((float)(phase >> 8) * (1.f / 16777216.f));
+}
+
+// Residual of a jump up by 1 at t = 0. Subtract it for a jump down
+inline float STS_PolyBLEP(float t, float dt)
+{
+	// Distance to the jump in samples, negative before it. Only the last and the first sample around it are corrected
+	float x = (t < 0.5f ? t : t - 1.f) / dt;
+	float a = std::fmax(1.f - std::fabs(x), 0.f);
+
+	return (x < 0.f ? 0.5f * a * a : -0.5f * a * a);
+}
+
+// Residual of a corner at t = 0 where the slope goes up by 1 per cycle: the integral of the PolyBLEP. Subtract it for a slope going down
+inline float STS_PolyBLAMP(float t, float dt)
+{
+	float x = (t < 0.5f ? t : t - 1.f) / dt;
+	float a = std::fmax(1.f - std::fabs(x), 0.f);
+
+	return (dt * a * a * a * (1.f / 6.f));
+}
+
+// The same for 4 poly channels at a time
+inline rack::simd::float_4 STS_Phase_Cycles(rack::simd::int32_4 phase)
+{
+	// The shift is arithmetic, so mask off the sign bits it drags in
+	return (rack::simd::float_4((phase >> 8) & 0x00ffffff) * (1.f / 16777216.f));
+}
+
+inline rack::simd::float_4 STS_PolyBLEP(rack::simd::float_4 t, rack::simd::float_4 dt)
+{
+	using rack::simd::float_4;
+
+	float_4 x = rack::simd::ifelse(t < 0.5f, t, t - 1.f) / dt;
+	float_4 a = rack::simd::fmax(1.f - rack::simd::fabs(x), float_4(0.f));
+
+	return (rack::simd::ifelse(x < 0.f, 0.5f * a * a, -0.5f * a * a));
+}
+
+inline rack::simd::float_4 STS_PolyBLAMP(rack::simd::float_4 t, rack::simd::float_4 dt)
+{
+	using rack::simd::float_4;
+
+	float_4 x = rack::simd::ifelse(t < 0.5f, t, t - 1.f) / dt;
+	float_4 a = rack::simd::fmax(1.f - rack::simd::fabs(x), float_4(0.f));
+
+	return (dt * a * a * a * (1.f / 6.f));
+}
+
+// Hard sync: a rising edge of the master through 0V resets the phase of the VCO. Where the edge falls between two samples is
+// interpolated from the last two samples of the master, so the reset lands at that fraction of the sample and the sync sweep stays in tune.
+// The jump of the wave at the reset is smoothed by a PolyBLEP over the sample before and the sample after the edge.
+// The sample before was computed already, so a synced VCO holds every sample back for one sample
+
+// Looks for a rising edge of the master since its last sample. Returns whether there is one, with *since the fraction of the sample since the edge
+inline bool STS_Sync_Edge(float sync_in, float *sync_prev, float *since)
+{
+	bool edge = (*sync_prev <= 0.f && sync_in > 0.f);
+
+	*since = (edge ? sync_in / (sync_in - *sync_prev) : 0.f);
+	*sync_prev = sync_in;
+	return (edge);
+}
+
+// Moves a phase on by inc cycles, resetting it at the edge if there is one. Returns the phase the VCO had at the edge
+inline uint32_t STS_Sync_Phase(uint32_t *phase, float inc, bool edge, float since)
+{
+	uint32_t edge_phase = *phase + STS_Fixed_Phase((1.f - since) * inc);
+
+	*phase = (edge ? STS_Fixed_Phase(since * inc) : *phase + STS_Fixed_Phase(inc));
+	return (edge_phase);
+}
+
+// Adds the PolyBLEP of a jump at the edge to the sample held back and to the new sample. Returns the sample held back and holds back the new one
+inline float STS_Sync_BLEP(float wave, bool edge, float jump, float since, float *held)
+{
+	float out = *held;
+
+	if (edge)
+	{
+		out += 0.5f * since * since * jump;
+		wave -= 0.5f * (1.f - since) * (1.f - since) * jump;
+	}
+	*held = wave;
+	return (out);
+}
+
+// The same for 4 poly channels at a time. The edges are lane masks
+inline rack::simd::float_4 STS_Sync_Edge(rack::simd::float_4 sync_in, float *sync_prev, rack::simd::float_4 *since)
+{
+	using rack::simd::float_4;
+
+	float_4 prev = float_4::load(sync_prev);
+	float_4 edge = (prev <= 0.f) & (sync_in > 0.f);
+
+	*since = rack::simd::ifelse(edge, sync_in / (sync_in - prev), float_4(0.f));
+	sync_in.store(sync_prev);
+	return (edge);
+}
+
+inline rack::simd::int32_4 STS_Sync_Phase(rack::simd::int32_4 *phase, rack::simd::float_4 inc, rack::simd::float_4 edge, rack::simd::float_4 since)
+{
+	rack::simd::int32_4 edge_phase = *phase + STS_Fixed_Phase((1.f - since) * inc);
+
+	*phase = rack::simd::ifelse(rack::simd::int32_4::cast(edge), STS_Fixed_Phase(since * inc), *phase + STS_Fixed_Phase(inc));
+	return (edge_phase);
+}
+
+inline rack::simd::float_4 STS_Sync_BLEP(rack::simd::float_4 wave, rack::simd::float_4 edge, rack::simd::float_4 jump, rack::simd::float_4 since, float *held)
+{
+	using rack::simd::float_4;
+
+	float_4 out = float_4::load(held);
+
+	jump = rack::simd::ifelse(edge, jump, float_4(0.f));
+	out += 0.5f * since * since * jump;
+	wave -= 0.5f * (1.f - since) * (1.f - since) * jump;
+	wave.store(held);
+	return (out);
+}
+
+// A job for the plugin-wide worker thread, which builds tables in the background so the audio thread never waits for a table
+// Jobs are queued through a link in the job itself, so queueing never allocates
+struct STS_Worker_Job
+{
+	STS_Worker_Job *next = NULL; // Next job in the queue, only touched under the worker lock
+	bool queued = false;
+
+	virtual ~STS_Worker_Job() {}
+
+	// Queues the job, unless it is queued already: the build picks up the latest requested values anyway
+	void Request();
+	// The same from the audio thread: gives up instead of waiting if the worker lock is taken. Returns whether the job was queued
+	bool Try_Request();
+	// Takes the job off the queue and waits for the worker thread if it is building it. Derived jobs call this first in their destructor
+	void Cancel();
+
+	// Called on the worker thread
+	virtual void Build() = 0;
+};
+
+// Holds the band-limited tables of one module and rebuilds them on the plugin-wide worker thread, so the audio thread never waits for a table
+// The audio thread keeps playing the current set until the new set is finished, then swaps it in through the atomic ready flag
+struct STS_Wavetable_Loader : STS_Worker_Job
+{
+	int waveform;
+	std::atomic<int> requested_max_Harm;
+	std::atomic<float> requested_sample_rate;
+	std::atomic<bool> ready; // A new set is waiting in the set not in use by the audio thread
+	int active = 0;			 // Set in use by the audio thread, only touched by the audio thread
+	int build = 0;			 // Set last written by the worker thread, only touched by the worker thread
+	STS_Wavetable_Set sets[2];
+
+	// Builds the first set right away, so the module has tables before its first process()
+	STS_Wavetable_Loader(int waveform, int max_Harm, float sample_rate = 44100.f);
+	// Waits for the worker thread if it is building for this loader
+	~STS_Wavetable_Loader();
+
+	// From any thread: limit the number of harmonics of all levels to max_Harm, 0 = only limited by Nyquist
+	void SetMax_Harmonics(int max_Harm);
+	// From any thread: rebuild the levels for a new sample rate
+	void SetSample_Rate(float sample_rate);
+
+	// From the audio thread only: the set to play from, swapping in a newly built set first
+	const STS_Wavetable_Set &Get()
+	{
+		if (ready.load(std::memory_order_acquire) && ready.exchange(false))
+			active ^= 1;
+		return sets[active];
+	}
+
+	// Used internally and by the worker thread
+	void Build_Set(STS_Wavetable_Set *set);
+	void Build() override;
+};
+
+// Additive waves: a sum of sines at whole multiples of the fundamental. Enough for a Harmoblender with 3 expanders
+#define STS_MAX_PARTIALS 64
+
+struct STS_Partial
+{
+	float level = 0.f;
+	uint32_t multiplication = 0;
+	uint32_t phase_shift = 0; // In fixed point cycles
+
+	bool operator!=(const STS_Partial &p) const { return level != p.level || multiplication != p.multiplication || phase_shift != p.phase_shift; }
+};
+
+// Bakes num partials into one single-cycle table right away. Slow, for the worker thread only
+void STS_Bake_Partials(STS_Wavetable *table, const STS_Partial *partials, int num);
+
+// Bakes a static additive timbre into one single-cycle table on the worker thread, so playing it is a single table read instead of a read per partial
+// The table is updated incrementally: only the partials that changed since the last build are taken out and added in again
+// Handing over the partials and picking up the table work like the loader above, without the audio thread ever waiting
+struct STS_Additive_Baker : STS_Worker_Job
+{
+	std::atomic<bool> ready;
+	int active = 0; // Table in use by the audio thread
+	int build = 0;	// Table last written by the worker thread
+	STS_Wavetable tables[2];
+	uint32_t generation[2] = {}; // Which hand-over each table was baked from
+
+	// Only touched by the audio thread
+	STS_Partial sent[STS_MAX_PARTIALS];
+	int sent_num = 0; // Partials after these are silent
+	uint32_t sent_generation = 0;
+
+	// Handed over under requested_mutex
+	std::mutex requested_mutex;
+	STS_Partial requested[STS_MAX_PARTIALS];
+	uint32_t requested_generation = 0;
+
+	// Only touched by the worker thread: the partials in the sum, kept in double precision so the incremental updates do not drift
+	STS_Partial applied[STS_MAX_PARTIALS];
+	double sum[STS_NUM_WAVE_SAMPLES] = {};
+
+	// Bakes the silent table right away, which also starts the worker thread: the audio thread cannot
+	STS_Additive_Baker() : ready(false) { Request(); }
+	~STS_Additive_Baker() { Cancel(); }
+
+	// From the audio thread only: bake the first num partials, the others silent, if they differ from the last ones
+	void Set_Partials(const STS_Partial *partials, int num);
+
+	// From the audio thread only: the table with the partials last set, or NULL if it is not baked yet
+	const STS_Wavetable *Get()
+	{
+		if (ready.load(std::memory_order_acquire) && ready.exchange(false))
+			active ^= 1;
+		return (generation[active] == sent_generation ? &tables[active] : NULL);
+	}
+
+	void Build() override;
+};